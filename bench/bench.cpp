@@ -0,0 +1,627 @@
+/**
+ * @file bench.cpp
+ * @author Thomas Roiseux
+ * @brief Benchmarks of the solvers, of the linear algebra and of the outputs, checks of the order of the time
+ * schemes, of the single precision solver and of the assembled operator of the plate, and checks that the time
+ * loops of the solvers do not allocate.
+ * Usage: bench.out [--quick] [--filter <prefix>] [--json <file>] [--baseline <file>] [--threshold <ratio>].
+ * Each kernel runs on grids of 10^2 to 10^5 points. The results can be written as JSON, and compared with
+ * the JSON of an earlier run: a kernel slower than the baseline by more than the threshold (default: 0.1)
+ * is a regression. The exit code is 1 if there is a regression or if a check fails.
+ * make bench RELEASE=TRUE [BASELINE=<file>] builds and runs it, writing bin/bench.json. make check builds it
+ * and only runs the checks.
+ * @version 0.1
+ * @date 2023-01-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../header/bar.h"
+#include "../header/binary.h"
+#include "../header/exn.h"
+#include "../header/grid.h"
+#include "../header/heatsolver.h"
+#include "../header/materials.h"
+#include "../header/matrix.h"
+#include "../header/multigrid.h"
+#include "../header/parallel.h"
+#include "../header/plate.h"
+#include "../header/profile.h"
+#include "../header/sink.h"
+#include "../header/stencil.h"
+#include "../header/stepping.h"
+#include "../header/utils.h"
+
+using namespace std;
+
+/**
+ * @brief Sink dropping the steps, so that only the solver is timed.
+ *
+ */
+class NullSink : public StepSink
+{
+public:
+    void consume(size_t, double, ConstStepView) override {};
+};
+
+/**
+ * @brief Sink keeping the last step.
+ *
+ */
+class LastStepSink : public StepSink
+{
+public:
+    vector<double> values;
+
+    void consume(size_t, double, ConstStepView step) override { values.assign(step.data(), step.data() + step.size()); };
+};
+
+/**
+ * @brief Result of a kernel.
+ *
+ */
+struct Result
+{
+    string name;
+    size_t points;
+    /**
+     * @brief Time of a call, in seconds.
+     *
+     */
+    double seconds;
+    /**
+     * @brief Number of points updated per call, 0 if the kernel does not advance a grid.
+     *
+     */
+    double updates;
+};
+
+/**
+ * @brief Result of a check: the order of a scheme, the error of a solver in single precision or of an assembled
+ * operator, or the allocations per time step of a solver.
+ *
+ */
+struct Check
+{
+    string name;
+    double expected;
+    double observed;
+    bool passed;
+};
+
+/**
+ * @brief Time a call, in seconds: the best of the repetitions run in minTime, and of at least 3.
+ *
+ * @param run Call.
+ * @param minTime Minimum time spent.
+ * @return double
+ */
+double measure(const function<void()>& run, double minTime)
+{
+    double best = INFINITY;
+    double total = 0;
+    for (size_t repetition = 0; repetition < 3 || total < minTime; repetition++)
+    {
+        const auto start = chrono::steady_clock::now();
+        run();
+        const double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        best = min(best, time);
+        total += time;
+    }
+    return best;
+}
+
+/**
+ * @brief Get the side of a square grid of about points points.
+ *
+ * @param points Number of points.
+ * @return size_t
+ */
+size_t side(size_t points)
+{
+    return static_cast<size_t>(llround(sqrt(static_cast<double>(points))));
+}
+
+/**
+ * @brief Benchmark the kernels.
+ *
+ * @param filter Only the kernels whose name starts with filter run.
+ * @param minTime Minimum time spent on each kernel and size.
+ * @return vector<Result>
+ */
+vector<Result> runKernels(const string& filter, double minTime)
+{
+    const vector<size_t> sizes = {100, 1000, 10000, 100000};
+    const Bar bar(13, 1, 16, 80, "cuivre");
+    const Plate plate(13, 0.5, 16, 80, "cuivre");
+    const size_t steps = 20;
+    vector<Result> results;
+    // A call of a kernel advancing the grid runs several steps: its timing is given per step.
+    auto run = [&](const string& name, size_t points, size_t calls, double updates, const function<void()>& call)
+    {
+        if (name.compare(0, filter.size(), filter) != 0)
+        {
+            return;
+        }
+        const Result result = {name, points, measure(call, minTime) / calls, updates};
+        results.push_back(result);
+        printf("%-18s %8zu %12.3e s", name.c_str(), points, result.seconds);
+        if (updates > 0)
+        {
+            printf(" %12.3e updates/s", updates / result.seconds);
+        }
+        printf("\n");
+        fflush(stdout);
+    };
+
+    for (size_t points : sizes)
+    {
+        // Dense LU on a matrix of points coefficients, diagonally dominant so that it needs no pivoting.
+        const size_t n = side(points);
+        if (n <= 320)
+        {
+            DenseMatrix A(n, n), L, U;
+            for (size_t i = 0; i < n; i++)
+            {
+                for (size_t j = 0; j < n; j++)
+                {
+                    A.at(i, j) = i == j ? 2.0 * n : 1.0 / (1 + i + j);
+                }
+            }
+            run("lu/decomp", points, 1, 0, [&]() { luDecomp(A, L, U); });
+            const vector<double> b(n, 1.0);
+            vector<double> x;
+            run("lu/solve", points, 1, 0, [&]() { luSolve(L, U, b, x); });
+        }
+
+        const Grid barGrid(bar.getTMax(), steps + 1, bar.getL(), points);
+        const double dt = barGrid.time.step();
+        BandedMatrix A, factorized;
+        bar.makeOperator(points, barGrid.x.step(), dt, A);
+        A.factorize();
+        run("bar/factorize", points, 1, 0, [&]()
+        {
+            bar.makeOperator(points, barGrid.x.step(), dt, factorized);
+            factorized.factorize();
+        });
+        vector<double> B, C;
+        run("bar/rhs", points, 1, 0, [&]() { bar.makeRightHandSide(barGrid, B, C); });
+        NullSink sink;
+        run("bar/step", points, steps, points, [&]() { bar.solve(barGrid, A, sink, steps); });
+        const vector<Bar> bars(8, bar);
+        vector<StepSink *> sinks(bars.size(), &sink);
+        run("bar/batch8", points, steps, 8.0 * points, [&]() { Bar::solveBatch(bars, barGrid, A, sinks, steps); });
+        // The same steps in single precision, on the factors of A.
+        bar.makeRightHandSide(barGrid, B, C);
+        const TridiagonalCopy<float> barFactors({A.band(), A.band() + 1, A.band() + 2, 3, points});
+        const vector<float> barBoundary(B.begin(), B.end()), barSource(C.begin(), C.end());
+        const float b = static_cast<float>(bar.diffusivity() / (barGrid.x.step() * barGrid.x.step()));
+        HeatSolver<1, Scheme::Euler, float> bar32({HeatAxis<float>{barFactors.view(), b}}, static_cast<float>(bar.getU0()), barBoundary.data(), barSource.data());
+        run("bar/step-f32", points, steps, points, [&]() { bar32.run(barGrid, sink, steps); });
+
+        const size_t m = side(points);
+        const Grid plateGrid(plate.getTMax(), steps + 1, plate.getL(), m, plate.getL(), m);
+        SolverOptions options;
+        options.every = steps;
+        run("plate/adi", m * m, steps, m * m, [&]() { plate.solve(plateGrid, sink, options); });
+        AdiOperator op;
+        plate.makeAdiOperator(m, m, plateGrid.x.step(), plateGrid.y.step(), Plate::operatorStep(Scheme::CrankNicolson, plateGrid.time.step()), op);
+        const TridiagonalCopy<float> plateFactors({op.lx.data(), op.ux.data(), op.upperX.data(), 1, m});
+        const Material &mat = Material::materials[plate.getMaterial()];
+        vector<float> plateSource(m * m);
+        for (size_t j = 0; j < m; j++)
+        {
+            for (size_t k = 0; k < m; k++)
+            {
+                plateSource[j * m + k] = static_cast<float>(plate(plateGrid.x[j], plateGrid.y[k]) / (mat.getDensity() * mat.getSpecificHeatCapacity()));
+            }
+        }
+        const float bp = static_cast<float>(plate.diffusivity() / (plateGrid.x.step() * plateGrid.x.step()));
+        const HeatAxis<float> axis = {plateFactors.view(), bp};
+        HeatSolver<2, Scheme::CrankNicolson, float> plate32({axis, axis}, static_cast<float>(plate.getU0()), nullptr, plateSource.data());
+        run("plate/adi-f32", m * m, steps, m * m, [&]() { plate32.run(plateGrid, sink, steps); });
+        SolverOptions multigrid = options;
+        multigrid.solver = LinearSolver::Multigrid;
+        run("plate/mg", m * m, steps, m * m, [&]() { plate.solve(plateGrid, sink, multigrid); });
+        vector<double> u(m * m, 1.0), y(m * m);
+        run("plate/stencil", m * m, 1, m * m, [&]() { stencil5(u.data(), y.data(), m, m, 0.5, 0.125, 0.125, 0); });
+        CsrMatrix csr;
+        plate.makeOperator(m, m, plateGrid.x.step(), plateGrid.y.step(), plateGrid.time.step(), csr);
+        const vector<double> ones(m * m, 1.0);
+        vector<double> product;
+        run("plate/csr", m * m, 1, m * m, [&]() { csr.multiply(ones, product); });
+
+        // Output of the steps of the bar: points values per step.
+        vector<double> values(points);
+        for (size_t j = 0; j < points; j++)
+        {
+            values[j] = 13 + sin(static_cast<double>(j));
+        }
+        const vector<double> &position = barGrid.x.points();
+        run("output/csv", points, steps, points, [&]()
+        {
+            ostringstream out;
+            CsvSink csv(out, ",", "Time/position,");
+            csv.begin(steps, position, {});
+            for (size_t i = 0; i < steps; i++)
+            {
+                csv.consume(i, i * dt, ConstStepView(values.data(), points, 1));
+            }
+            csv.end();
+        });
+        run("output/binary", points, steps, points, [&]()
+        {
+            BinaryWriter binary("bench-output.bin", {13, 80, 1, 16, dt, "cuivre"});
+            binary.begin(steps, position, {});
+            for (size_t i = 0; i < steps; i++)
+            {
+                binary.consume(i, i * dt, ConstStepView(values.data(), points, 1));
+            }
+            binary.end();
+        });
+    }
+    remove("bench-output.bin");
+    return results;
+}
+
+/**
+ * @brief Maximum difference between two vectors.
+ *
+ * @param a First vector.
+ * @param b Second vector.
+ * @return double
+ */
+double maxError(const vector<double>& a, const vector<double>& b)
+{
+    double error = 0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        error = max(error, fabs(a[i] - b[i]));
+    }
+    return error;
+}
+
+/**
+ * @brief Check the order of the time schemes, and of the default scheme of each model: the error at tMax against
+ * a Crank-Nicolson solution with 20480 steps, on a 41 point grid, should be divided by 2^order when the number of
+ * steps doubles. The bar solved in single precision should match its solve in double precision, and the
+ * assembled operator of the plate its matrix-free operator.
+ *
+ * @return vector<Check>
+ */
+vector<Check> runChecks()
+{
+    const Bar bar(20, 0.1, 50, 10, "fer");
+    const Plate plate(20, 0.1, 50, 10, "fer");
+    const size_t n = 41;
+    const size_t referenceSteps = 20480;
+    auto last = [](const function<void(StepSink&)>& solve)
+    {
+        LastStepSink sink;
+        solve(sink);
+        return sink.values;
+    };
+    auto solveBar = [&](size_t steps, optional<Scheme> scheme)
+    {
+        SolverOptions options;
+        options.scheme = scheme;
+        options.every = steps;
+        return last([&](StepSink& sink) { bar.solve(Grid(bar.getTMax(), steps + 1, bar.getL(), n), sink, options); });
+    };
+    auto solvePlate = [&](size_t steps, optional<Scheme> scheme)
+    {
+        SolverOptions options;
+        options.scheme = scheme;
+        options.every = steps;
+        return last([&](StepSink& sink) { plate.solve(Grid(plate.getTMax(), steps + 1, plate.getL(), n, plate.getL(), n), sink, options); });
+    };
+
+    struct Model
+    {
+        string name;
+        function<vector<double>(size_t, optional<Scheme>)> solve;
+        Scheme defaultScheme;
+    };
+    vector<Check> checks;
+    const vector<Model> models = {{"bar", solveBar, Bar::defaultScheme}, {"plate", solvePlate, Plate::defaultScheme}};
+    for (const Model &model : models)
+    {
+        const vector<double> reference = model.solve(referenceSteps, Scheme::CrankNicolson);
+        // No scheme is the default scheme of the model.
+        for (const optional<Scheme> scheme : {optional<Scheme>(), optional<Scheme>(Scheme::Euler), optional<Scheme>(Scheme::CrankNicolson)})
+        {
+            // Order observed between 160 and 320 steps, far enough from the reference.
+            const double coarse = maxError(model.solve(160, scheme), reference);
+            const double fine = maxError(model.solve(320, scheme), reference);
+            const double expected = order(scheme.value_or(model.defaultScheme));
+            const double observed = log2(coarse / fine);
+            const string name = model.name + "/" + (!scheme ? "default" : scheme == Scheme::Euler ? "euler" : "cn");
+            checks.push_back({name, expected, observed, observed > expected - 0.2});
+            printf("%-22s order %.2f (expected %.0f) %s\n", name.c_str(), observed, expected, checks.back().passed ? "ok" : "FAILED");
+        }
+    }
+
+    // Single precision: the relative error of the Crank-Nicolson bar against the same solve in double precision.
+    const size_t steps = 320;
+    const Grid grid(bar.getTMax(), steps + 1, bar.getL(), n);
+    BandedMatrix A;
+    bar.makeOperator(n, grid.x.step(), Bar::operatorStep(Scheme::CrankNicolson, grid.time.step()), A);
+    A.factorize();
+    vector<double> B, C;
+    bar.makeRightHandSide(grid, B, C);
+    const TridiagonalCopy<float> factors({A.band(), A.band() + 1, A.band() + 2, 3, n});
+    const vector<float> boundary(B.begin(), B.end()), source(C.begin(), C.end());
+    const float b = static_cast<float>(bar.diffusivity() / (grid.x.step() * grid.x.step()));
+    HeatSolver<1, Scheme::CrankNicolson, float> solver({HeatAxis<float>{factors.view(), b}}, static_cast<float>(bar.getU0()), boundary.data(), source.data());
+    const vector<double> single = last([&](StepSink& sink) { solver.run(grid, sink, steps); });
+    const vector<double> reference = solveBar(steps, Scheme::CrankNicolson);
+    const double expected = 1e-4;
+    const double observed = maxError(single, reference) / *max_element(reference.begin(), reference.end());
+    checks.push_back({"bar/cn-f32", expected, observed, observed < expected});
+    printf("%-22s error %.2e (expected < %.0e) %s\n", "bar/cn-f32", observed, expected, checks.back().passed ? "ok" : "FAILED");
+
+    // Assembled operator of the plate: its product with a vector against the matrix-free operator of the
+    // iterative solvers, which applies -A with a shift of 1 / dt.
+    const Grid plateGrid(plate.getTMax(), steps + 1, plate.getL(), n, plate.getL(), n);
+    const double bx = plate.diffusivity() / (plateGrid.x.step() * plateGrid.x.step());
+    const double by = plate.diffusivity() / (plateGrid.y.step() * plateGrid.y.step());
+    CsrMatrix csr;
+    plate.makeOperator(n, n, plateGrid.x.step(), plateGrid.y.step(), plateGrid.time.step(), csr);
+    const Multigrid mg(n, n, bx, by, 1 / plateGrid.time.step());
+    vector<double> x(n * n), assembled, matrixFree(n * n);
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = 20 + sin(static_cast<double>(i));
+    }
+    csr.multiply(x, assembled);
+    mg.apply(x.data(), matrixFree.data());
+    double error = 0, scale = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        error = max(error, fabs(assembled[i] + matrixFree[i]));
+        scale = max(scale, fabs(matrixFree[i]));
+    }
+    const double csrExpected = 1e-12;
+    const double csrObserved = error / scale;
+    checks.push_back({"plate/csr", csrExpected, csrObserved, csrObserved < csrExpected});
+    printf("%-22s error %.2e (expected < %.0e) %s\n", "plate/csr", csrObserved, csrExpected, checks.back().passed ? "ok" : "FAILED");
+    return checks;
+}
+
+/**
+ * @brief Check that the time loops do not allocate: a solve of 200 steps should allocate as much as one of
+ * 100 steps of the same length, for each model, scheme and linear solver. A first solve fills the factorization
+ * cache, so that both find the same operators. Enables the profiler, which counts the allocations.
+ *
+ * @return vector<Check>
+ */
+vector<Check> runAllocationChecks()
+{
+    Profiler::global().enable();
+    const Bar bar(20, 0.1, 50, 10, "fer");
+    const Plate plate(20, 0.1, 50, 10, "fer");
+    const size_t n = 41;
+    auto allocations = [&](bool isPlate, const SolverOptions& base, size_t steps)
+    {
+        SolverOptions options = base;
+        options.every = steps;
+        NullSink sink;
+        const uint64_t before = Profiler::value(Counter::Allocations);
+        if (isPlate)
+        {
+            plate.solve(Grid(plate.getTMax() * steps / 200, steps + 1, plate.getL(), n, plate.getL(), n), sink, options);
+        }
+        else
+        {
+            bar.solve(Grid(bar.getTMax() * steps / 200, steps + 1, bar.getL(), n), sink, options);
+        }
+        return Profiler::value(Counter::Allocations) - before;
+    };
+
+    struct Case
+    {
+        string name;
+        bool plate;
+        Scheme scheme;
+        LinearSolver solver;
+        Smoother smoother;
+    };
+    const vector<Case> cases = {
+        {"bar/euler", false, Scheme::Euler, LinearSolver::Direct, Smoother::GaussSeidel},
+        {"bar/cn", false, Scheme::CrankNicolson, LinearSolver::Direct, Smoother::GaussSeidel},
+        {"bar/ftcs", false, Scheme::Explicit, LinearSolver::Direct, Smoother::GaussSeidel},
+        {"plate/adi", true, Scheme::CrankNicolson, LinearSolver::Direct, Smoother::GaussSeidel},
+        {"plate/ftcs", true, Scheme::Explicit, LinearSolver::Direct, Smoother::GaussSeidel},
+        {"plate/mg", true, Scheme::Euler, LinearSolver::Multigrid, Smoother::GaussSeidel},
+        {"plate/mg-jacobi", true, Scheme::CrankNicolson, LinearSolver::Multigrid, Smoother::Jacobi},
+        {"plate/pcg", true, Scheme::Euler, LinearSolver::ConjugateGradient, Smoother::GaussSeidel}
+    };
+    vector<Check> checks;
+    for (const Case &c : cases)
+    {
+        SolverOptions options;
+        options.scheme = c.scheme;
+        options.solver = c.solver;
+        options.smoother = c.smoother;
+        allocations(c.plate, options, 100);
+        const double extra = static_cast<double>(allocations(c.plate, options, 200)) - static_cast<double>(allocations(c.plate, options, 100));
+        const string name = "alloc/" + c.name;
+        checks.push_back({name, 0, extra / 100, extra == 0});
+        printf("%-22s %.2f allocations per step %s\n", name.c_str(), extra / 100, checks.back().passed ? "ok" : "FAILED");
+    }
+    return checks;
+}
+
+/**
+ * @brief Write the results as JSON, one kernel per line.
+ *
+ * @param filename File.
+ * @param results Results of the kernels.
+ * @param checks Convergence checks.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void writeJson(const string& filename, const vector<Result>& results, const vector<Check>& checks)
+{
+    ofstream out(filename);
+    if (!out.is_open())
+    {
+        throw runtime_error("Unable to open file " + filename);
+    }
+    char line[256];
+    out << "{\n  \"isa\": \"" << stencilIsa() << "\",\n  \"threads\": " << ParallelPool::global().size() << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &r = results[i];
+        snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"points\": %zu, \"seconds\": %.6e, \"updatesPerSecond\": %.6e}%s\n", r.name.c_str(), r.points, r.seconds, r.updates > 0 ? r.updates / r.seconds : 0.0, i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ],\n  \"checks\": [\n";
+    for (size_t i = 0; i < checks.size(); i++)
+    {
+        const Check &c = checks[i];
+        snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"expected\": %g, \"observed\": %.4g, \"passed\": %s}%s\n", c.name.c_str(), c.expected, c.observed, c.passed ? "true" : "false", i + 1 < checks.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+    if (!out)
+    {
+        throw runtime_error("Unable to write file " + filename);
+    }
+}
+
+/**
+ * @brief Read the kernel timings of a JSON file written by {@link writeJson}.
+ *
+ * @param filename File.
+ * @return map<pair<string, size_t>, double> Seconds of each kernel and size.
+ * @throws std::runtime_error if the file cannot be read.
+ */
+map<pair<string, size_t>, double> readBaseline(const string& filename)
+{
+    ifstream in(filename);
+    if (!in.is_open())
+    {
+        throw runtime_error("Unable to open file " + filename);
+    }
+    map<pair<string, size_t>, double> baseline;
+    string line;
+    while (getline(in, line))
+    {
+        char name[128];
+        size_t points;
+        double seconds;
+        if (sscanf(line.c_str(), " {\"name\": \"%127[^\"]\", \"points\": %zu, \"seconds\": %lf", name, &points, &seconds) == 3)
+        {
+            baseline[{name, points}] = seconds;
+        }
+    }
+    return baseline;
+}
+
+/**
+ * @brief Compare the results with a baseline.
+ *
+ * @param results Results of the kernels.
+ * @param baseline Seconds of each kernel and size in the baseline.
+ * @param threshold Relative slowdown above which a kernel is a regression.
+ * @return size_t Number of regressions.
+ */
+size_t compare(const vector<Result>& results, const map<pair<string, size_t>, double>& baseline, double threshold)
+{
+    size_t regressions = 0;
+    cout << endl << "Comparison with the baseline (time / baseline time):" << endl;
+    for (const Result &r : results)
+    {
+        const auto it = baseline.find({r.name, r.points});
+        if (it == baseline.end())
+        {
+            continue;
+        }
+        const double ratio = r.seconds / it->second;
+        const bool regression = ratio > 1 + threshold;
+        regressions += regression;
+        printf("%-18s %8zu %8.3f%s\n", r.name.c_str(), r.points, ratio, regression ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    string filter, jsonFilename, baselineFilename;
+    double minTime = 0.2;
+    double threshold = 0.1;
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            minTime = 0.02;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && hasValue)
+        {
+            jsonFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+        {
+            baselineFilename = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && hasValue && sscanf(argv[i + 1], "%lf", &threshold) == 1)
+        {
+            i++;
+        }
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [--quick] [--filter <prefix>] [--json <file>] [--baseline <file>] [--threshold <ratio>]" << endl;
+            return 2;
+        }
+    }
+
+    try
+    {
+        printf("Stencil kernels: %s, %zu threads.\n\n", stencilIsa(), ParallelPool::global().size());
+        const vector<Result> results = runKernels(filter, minTime);
+        cout << endl;
+        vector<Check> checks;
+        if (filter.empty() || string("checks").compare(0, filter.size(), filter) == 0)
+        {
+            checks = runChecks();
+            const vector<Check> allocationChecks = runAllocationChecks();
+            checks.insert(checks.end(), allocationChecks.begin(), allocationChecks.end());
+        }
+        if (!jsonFilename.empty())
+        {
+            writeJson(jsonFilename, results, checks);
+            cout << "Results saved in " << jsonFilename << endl;
+        }
+        size_t failures = count_if(checks.begin(), checks.end(), [](const Check& c) { return !c.passed; });
+        if (!baselineFilename.empty())
+        {
+            failures += compare(results, readBaseline(baselineFilename), threshold);
+        }
+        return failures == 0 ? 0 : 1;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
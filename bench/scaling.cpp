@@ -0,0 +1,117 @@
+/**
+ * @file scaling.cpp
+ * @author Thomas Roiseux
+ * @brief Strong scaling of the plate solvers with the number of threads.
+ * Usage: scaling.out [n] [max threads]. Each solver runs on a n x n plate (default: 2048) with 1, 2, 4, ...
+ * threads, up to the given maximum (default: one per hardware thread).
+ * @version 0.1
+ * @date 2023-01-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../header/grid.h"
+#include "../header/parallel.h"
+#include "../header/plate.h"
+#include "../header/sink.h"
+#include "../header/stepping.h"
+
+using namespace std;
+
+/**
+ * @brief Sink dropping the steps, so that only the solver is timed.
+ *
+ */
+class NullSink : public StepSink
+{
+public:
+    void consume(size_t, double, ConstStepView) override {};
+};
+
+/**
+ * @brief Time a run, in seconds.
+ *
+ * @param run Run.
+ * @return double
+ */
+double timeRun(const function<void()>& run)
+{
+    const auto start = chrono::steady_clock::now();
+    run();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = 2048;
+    size_t maxThreads = max(1u, thread::hardware_concurrency());
+    if (argc > 1 && !sscanf(argv[1], "%zu", &n))
+    {
+        cerr << "Invalid size." << endl;
+        return 1;
+    }
+    if (argc > 2 && (!sscanf(argv[2], "%zu", &maxThreads) || maxThreads == 0))
+    {
+        cerr << "Invalid number of threads." << endl;
+        return 1;
+    }
+
+    const Plate plate(13, 0.5, 16, 80, "cuivre");
+    NullSink sink;
+    struct Case
+    {
+        string name;
+        function<void()> run;
+    };
+    vector<Case> cases = {
+        {"adi", [&]()
+        {
+            SolverOptions options;
+            options.every = 1000;
+            plate.solve(Grid(plate.getTMax(), 17, plate.getL(), n, plate.getL(), n), sink, options);
+        }},
+        {"mg-steady", [&]()
+        {
+            SolverOptions options;
+            options.solver = LinearSolver::Multigrid;
+            plate.solveSteady(Grid(plate.getTMax(), 2, plate.getL(), n, plate.getL(), n), sink, options);
+        }},
+        {"ftcs", [&]()
+        {
+            SolverOptions options;
+            options.scheme = Scheme::Explicit;
+            options.every = 1000;
+            plate.solve(Grid(0.01, 2, plate.getL(), n, plate.getL(), n), sink, options);
+        }},
+    };
+
+    cout << "solver\tthreads\ttime (s)\tspeedup\tefficiency" << endl;
+    for (const Case &c : cases)
+    {
+        double serial = 0;
+        for (size_t threads = 1; ; threads = min(2 * threads, maxThreads))
+        {
+            ParallelPool::setGlobalThreads(threads);
+            const double time = timeRun(c.run);
+            if (threads == 1)
+            {
+                serial = time;
+            }
+            printf("%s\t%zu\t%.3f\t%.2f\t%.2f\n", c.name.c_str(), threads, time, serial / time, serial / time / threads);
+            fflush(stdout);
+            if (threads == maxThreads)
+            {
+                break;
+            }
+        }
+    }
+    return 0;
+}
@@ -15,6 +15,11 @@
 #include <functional>
 #include <string>
 #include <vector>
+#include "grid.h"
+#include "matrix.h"
+#include "sink.h"
+#include "solution.h"
+#include "stepping.h"
 
 /**
  * @brief Class for the bar model.
@@ -30,6 +35,12 @@ private:
     double f;
     std::string material;
 public:
+    /**
+     * @brief Scheme used when the options do not choose one: implicit Euler.
+     * 
+     */
+    static constexpr Scheme defaultScheme = Scheme::Euler;
+
     /**
      * @brief Construct a new Bar object.
      * 
@@ -74,6 +85,13 @@ public:
      * @return double 
      */
     double getF() const { return f; };
+
+    /**
+     * @brief Get the Material object name.
+     * 
+     * @return const std::string& 
+     */
+    const std::string& getMaterial() const { return material; };
     /**
      * @brief Get the value of the source.
      * 
@@ -82,14 +100,123 @@ public:
      */
     double operator()(double x) const { return this->F(x); };
 
+    /**
+     * @brief Get the thermal diffusivity of the material, lambda / (rho * cp).
+     * 
+     * @return double 
+     */
+    double diffusivity() const;
+
+    /**
+     * @brief Get the time step of the operator used by a scheme: the Crank-Nicolson scheme
+     * solves with the implicit Euler operator for dt / 2.
+     * 
+     * @param scheme Scheme.
+     * @param dt Time step.
+     * @return double Time step to give to {@link makeOperator}.
+     */
+    static double operatorStep(Scheme scheme, double dt);
+
+    /**
+     * @brief Assemble the tridiagonal matrix of the implicit Euler scheme.
+     * 
+     * @param n Number of points.
+     * @param dx Space step.
+     * @param dt Time step.
+     * @param A Matrix to fill.
+     */
+    void makeOperator(size_t n, double dx, double dt, BandedMatrix& A) const;
+
+    /**
+     * @brief Compute the terms of the right-hand side which do not depend on time:
+     * the boundary term B (-b * u0 at both ends) and the source term C (-F / (rho * cp)).
+     * 
+     * @param grid Grid.
+     * @param B Boundary term to fill.
+     * @param C Source term to fill.
+     */
+    void makeRightHandSide(const Grid& grid, std::vector<double>& B, std::vector<double>& C) const;
+
+    /**
+     * @brief Compute the equilibrium temperature, solution of -lambda u'' = F with u = u0 outside of the bar.
+     * 
+     * @param grid Grid, along x.
+     * @param u Temperature, resized to grid.x.size().
+     */
+    void steadyState(const Grid& grid, std::vector<double>& u) const;
+
+    /**
+     * @brief Stream the equilibrium temperature as a single step. Its time is tMax, the end of the time axis
+     * of the grid, so that the outputs only hold finite times.
+     * 
+     * @param grid Grid, along time and x.
+     * @param sink Sink receiving the step.
+     * @param options Options of the solve, unused: the system is tridiagonal, so it is always solved directly.
+     */
+    void solveSteady(const Grid& grid, StepSink& sink, const SolverOptions& options = SolverOptions()) const;
+
     /**
      * @brief Solve the bar model, using a finite differences method.
      * 
-     * @param time Vector of time.
-     * @param position Vector of position.
-     * @param sol Vector of solution.
+     * @param grid Grid, along time and x.
+     * @param sol Solution, resized to grid.time.size() x grid.x.size().
+     */
+    void solve(const Grid& grid, Solution& sol) const;
+
+    /**
+     * @brief Solve the bar model, streaming the time steps. Only the current and the
+     * next steps are kept in memory. The operators come from {@link FactorizationCache::global}.
+     * 
+     * @param grid Grid, along time and x.
+     * @param sink Sink receiving the steps.
+     * @param options Options of the solve. With a tolerance, the time steps are adaptive (see {@link solveAdaptive}).
+     * @return StepStats 
+     */
+    StepStats solve(const Grid& grid, StepSink& sink, const SolverOptions& options = SolverOptions()) const;
+
+    /**
+     * @brief Solve the bar model with an operator built by {@link makeOperator} and factorized beforehand.
+     * The operator only depends on the material and on the grid, so it can be shared between bars.
+     * 
+     * @param grid Grid, along time and x.
+     * @param A Factorized operator, for the same material, number of points, dx and operatorStep(scheme, dt).
+     * @param sink Sink receiving the steps.
+     * @param every Only one step out of every is streamed (the first and the last steps always are).
+     * @param scheme Time integration scheme, implicit.
+     * @throws Exn if A is not a factorized tridiagonal matrix matching the grid, or if the scheme is explicit.
+     */
+    void solve(const Grid& grid, const BandedMatrix& A, StepSink& sink, size_t every = 1, Scheme scheme = defaultScheme) const;
+
+    /**
+     * @brief Solve several bars sharing their material and grid, which only differ by u0 and f.
+     * The implicit steps use the same operator, so the bars are advanced together in a structure of
+     * arrays layout (point j of bar c at j * bars.size() + c), one SIMD lane per bar
+     * (see {@link BandedMatrix::solve}). Each bar gets the same steps as with {@link solve}.
+     * The adaptive and the explicit schemes solve the bars one after the other.
+     * 
+     * @param bars Bars.
+     * @param grid Grid, along time and x.
+     * @param sinks Sink receiving the steps of each bar.
+     * @param options Options of the solve.
+     * @return StepStats Statistics of the whole batch.
+     * @throws Exn if the bars do not share their material and length, or if there is not one sink per bar.
+     */
+    static StepStats solveBatch(const std::vector<Bar>& bars, const Grid& grid, const std::vector<StepSink*>& sinks, const SolverOptions& options = SolverOptions());
+
+    /**
+     * @brief Solve several bars with an operator built by {@link makeOperator} and factorized beforehand
+     * (see {@link solveBatch}).
+     * 
+     * @param bars Bars, sharing their material and length.
+     * @param grid Grid, along time and x.
+     * @param A Factorized operator, for the same material, number of points, dx and operatorStep(scheme, dt).
+     * @param sinks Sink receiving the steps of each bar.
+     * @param every Only one step out of every is streamed (the first and the last steps always are).
+     * @param scheme Time integration scheme, implicit.
+     * @throws Exn if A is not a factorized tridiagonal matrix matching the grid, if the scheme is explicit, if the bars
+     * do not share their material and length, or if there is not one sink per bar.
      */
-    void solve(const std::vector<double>& time, const std::vector<double>& position, std::vector<std::vector<double>>& sol) const;
+    static void solveBatch(const std::vector<Bar>& bars, const Grid& grid, const BandedMatrix& A, const std::vector<StepSink*>& sinks, size_t every = 1, Scheme scheme = defaultScheme);
 };
 
 #endif // BAR_H
\ No newline at end of file
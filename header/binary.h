@@ -0,0 +1,228 @@
+/**
+ * @file binary.h
+ * @author Thomas Roiseux
+ * @brief Provides the binary output format: a {@link BinaryWriter} sink and a memory-mapped {@link BinaryResult} reader.
+ *
+ * A file is made of a 256 bytes {@link BinaryHeader}, the time of each step (float64)
+ * and, starting at a 64 bytes aligned offset, the values of each step (float64 or float32).
+ * Everything is little-endian. Value (i, j, k) is at index (i * sizeX + j) * sizeY + k.
+ * @version 0.1
+ * @date 2023-01-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sink.h"
+#include "solution.h"
+
+/**
+ * @brief Header of a binary result file.
+ *
+ */
+struct BinaryHeader
+{
+    /**
+     * @brief Always "HEATEQ" followed by two zero bytes.
+     *
+     */
+    char magic[8];
+    uint32_t version;
+    /**
+     * @brief Size of a value: 8 (float64) or 4 (float32).
+     *
+     */
+    uint32_t valueSize;
+    uint64_t steps;
+    uint64_t sizeX;
+    /**
+     * @brief Number of points along y, 1 for a bar.
+     *
+     */
+    uint64_t sizeY;
+    uint64_t timesOffset;
+    uint64_t valuesOffset;
+    /**
+     * @brief Time step of the solver (steps may be further apart if some were skipped).
+     *
+     */
+    double dt;
+    double dx;
+    /**
+     * @brief Space step along y, 0 for a bar.
+     *
+     */
+    double dy;
+    double u0;
+    double f;
+    double L;
+    double tMax;
+    char material[64];
+    char reserved[80];
+};
+
+static_assert(sizeof(BinaryHeader) == 256, "BinaryHeader must be 256 bytes long.");
+
+/**
+ * @brief Description of the model written in the header.
+ *
+ */
+struct BinaryInfo
+{
+    double u0;
+    double f;
+    double L;
+    double tMax;
+    double dt;
+    std::string material;
+};
+
+/**
+ * @brief Build the header of a result file.
+ *
+ * @param info Description of the model.
+ * @param steps Number of steps.
+ * @param positionX Position along x.
+ * @param positionY Position along y, empty for a bar.
+ * @param singlePrecision If values are written as float32 instead of float64.
+ * @return BinaryHeader
+ */
+BinaryHeader makeBinaryHeader(const BinaryInfo& info, size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY, bool singlePrecision);
+
+/**
+ * @brief Convert the fields of a header to little-endian, as written in the file.
+ *
+ * @param header Header, in the byte order of the host.
+ * @return BinaryHeader
+ */
+BinaryHeader littleEndian(const BinaryHeader& header);
+
+/**
+ * @brief Sink writing the steps in the binary format, through a large write buffer.
+ *
+ */
+class BinaryWriter : public StepSink
+{
+private:
+    std::string filename;
+    BinaryInfo info;
+    bool singlePrecision;
+    int fd;
+    BinaryHeader header;
+    std::vector<double> time;
+    std::vector<char> buffer;
+    size_t used;
+    uint64_t offset;
+
+    void flush();
+public:
+    /**
+     * @brief Size of the write buffer, in bytes.
+     *
+     */
+    static constexpr size_t bufferSize = 8 << 20;
+
+    /**
+     * @brief Construct a new Binary Writer object. The file is created when the stream begins.
+     *
+     * @param filename File to write.
+     * @param info Description of the model.
+     * @param singlePrecision If values are written as float32 instead of float64.
+     */
+    BinaryWriter(const std::string& filename, const BinaryInfo& info, bool singlePrecision = false);
+    BinaryWriter(const BinaryWriter&) = delete;
+    BinaryWriter& operator=(const BinaryWriter&) = delete;
+    /**
+     * @brief Destroy the Binary Writer object, closing the file if needed.
+     *
+     */
+    ~BinaryWriter();
+
+    /**
+     * @throws std::runtime_error if the file cannot be created or written.
+     */
+    void begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY) override;
+    /**
+     * @throws std::runtime_error if the file cannot be written, or if there are more steps than announced by begin.
+     */
+    void consume(size_t i, double t, ConstStepView step) override;
+    void end() override;
+};
+
+/**
+ * @brief Result file mapped in memory. Values are read in place, without any copy.
+ *
+ */
+class BinaryResult
+{
+private:
+    void *map;
+    size_t length;
+    const BinaryHeader *hdr;
+public:
+    /**
+     * @brief Map a result file.
+     *
+     * @param filename File to read.
+     * @throws std::runtime_error if the file cannot be mapped or is not a valid result file.
+     */
+    explicit BinaryResult(const std::string& filename);
+    BinaryResult(const BinaryResult&) = delete;
+    BinaryResult& operator=(const BinaryResult&) = delete;
+    /**
+     * @brief Destroy the Binary Result object, unmapping the file.
+     *
+     */
+    ~BinaryResult();
+
+    /**
+     * @brief Get the header.
+     *
+     * @return const BinaryHeader&
+     */
+    const BinaryHeader& header() const { return *hdr; };
+
+    /**
+     * @brief Get the time of a step.
+     *
+     * @param i Step.
+     * @return double
+     */
+    double time(size_t i) const;
+
+    /**
+     * @brief Get a value, whatever the precision of the file.
+     *
+     * @param i Step.
+     * @param j Index along x.
+     * @param k Index along y.
+     * @return double
+     */
+    double value(size_t i, size_t j, size_t k = 0) const;
+
+    /**
+     * @brief Get a view on a step of a float64 file.
+     *
+     * @param i Step.
+     * @return ConstStepView
+     * @throws Exn if the file holds float32 values.
+     */
+    ConstStepView step(size_t i) const;
+
+    /**
+     * @brief Get the float32 values of a file.
+     *
+     * @return const float*
+     * @throws Exn if the file holds float64 values.
+     */
+    const float* floatValues() const;
+};
+
+#endif // BINARY_H
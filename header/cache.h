@@ -0,0 +1,204 @@
+/**
+ * @file cache.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link FactorizationCache} class, which shares factorized operators between solves.
+ * @version 0.1
+ * @date 2023-01-09
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "bar.h"
+#include "matrix.h"
+#include "plate.h"
+
+/**
+ * @brief Identifies an operator: it only depends on the material coefficients and on the discretization,
+ * not on the initial temperature nor on the source.
+ *
+ */
+struct OperatorKey
+{
+    bool plate;
+    double lambda;
+    double rho;
+    double cp;
+    size_t nx;
+    size_t ny;
+    double dx;
+    double dy;
+    double dt;
+
+    bool operator<(const OperatorKey& other) const;
+    bool operator==(const OperatorKey& other) const;
+};
+
+/**
+ * @brief Thread-safe cache of factorized operators, kept in memory and optionally persisted in a directory.
+ * Concurrent requests for the same operator build it once: the other callers wait for it.
+ * The operators kept in memory are bounded by a budget of bytes: the least recently used ones are forgotten
+ * first. A forgotten operator stays valid for the solves holding it.
+ *
+ */
+class FactorizationCache
+{
+private:
+    /**
+     * @brief Operator kept in memory.
+     *
+     * @tparam T Type of the operator.
+     */
+    template <typename T>
+    struct Entry
+    {
+        std::shared_future<std::shared_ptr<const T>> op;
+        /**
+         * @brief Size of the operator, 0 while it is being built.
+         *
+         */
+        size_t bytes;
+        /**
+         * @brief Value of the use counter when the operator was last requested.
+         *
+         */
+        uint64_t lastUse;
+    };
+
+    mutable std::mutex mutex;
+    std::map<OperatorKey, Entry<BandedMatrix>> bars;
+    std::map<OperatorKey, Entry<AdiOperator>> plates;
+    std::string directory;
+    size_t budget;
+    size_t bytes;
+    uint64_t uses;
+    size_t hitCount;
+    size_t missCount;
+
+    /**
+     * @brief Get the file persisting an operator.
+     *
+     * @param key Key of the operator.
+     * @return std::string Empty if the cache is not persisted.
+     */
+    std::string path(const OperatorKey& key) const;
+
+    /**
+     * @brief Get an operator from memory, from disk, or build it.
+     *
+     * @tparam T Type of the operator.
+     * @param entries Operators of this type kept in memory.
+     * @param key Key of the operator.
+     * @param build Builds the operator.
+     * @return std::shared_ptr<const T>
+     */
+    template <typename T>
+    std::shared_ptr<const T> get(std::map<OperatorKey, Entry<T>>& entries, const OperatorKey& key, const std::function<void(T&)>& build);
+
+    /**
+     * @brief Forget the least recently used operators until the memory fits in the budget.
+     * Operators being built are kept. The mutex must be held.
+     *
+     */
+    void evict();
+public:
+    /**
+     * @brief Default budget of the operators kept in memory, in bytes.
+     *
+     */
+    static constexpr size_t defaultBudget = size_t(1) << 30;
+
+    /**
+     * @brief Construct a new Factorization Cache object.
+     *
+     * @param directory Directory where the operators are persisted, empty to keep them in memory only.
+     * @param budget Size of the operators kept in memory, in bytes.
+     */
+    explicit FactorizationCache(const std::string& directory = "", size_t budget = defaultBudget);
+    FactorizationCache(const FactorizationCache&) = delete;
+    FactorizationCache& operator=(const FactorizationCache&) = delete;
+    /**
+     * @brief Destroy the Factorization Cache object.
+     *
+     */
+    ~FactorizationCache();
+
+    /**
+     * @brief Get the cache used by the solvers.
+     *
+     * @return FactorizationCache&
+     */
+    static FactorizationCache& global();
+
+    /**
+     * @brief Set the directory where the operators are persisted, empty to keep them in memory only.
+     * The directory is created if needed.
+     *
+     * @param directory Directory.
+     */
+    void setDirectory(const std::string& directory);
+
+    /**
+     * @brief Get the factorized operator of a bar (see {@link Bar::makeOperator}).
+     *
+     * @param bar Bar.
+     * @param n Number of nodes.
+     * @param dx Space step.
+     * @param dt Time step.
+     * @return std::shared_ptr<const BandedMatrix>
+     */
+    std::shared_ptr<const BandedMatrix> barOperator(const Bar& bar, size_t n, double dx, double dt);
+
+    /**
+     * @brief Get the operator of a plate (see {@link Plate::makeAdiOperator}).
+     *
+     * @param plate Plate.
+     * @param nx Number of nodes along x.
+     * @param ny Number of nodes along y.
+     * @param dx Space step along x.
+     * @param dy Space step along y.
+     * @param dt Time step.
+     * @return std::shared_ptr<const AdiOperator>
+     */
+    std::shared_ptr<const AdiOperator> plateOperator(const Plate& plate, size_t nx, size_t ny, double dx, double dy, double dt);
+
+    /**
+     * @brief Forget the operators kept in memory. Persisted operators are kept.
+     *
+     */
+    void clear();
+
+    /**
+     * @brief Get the size of the operators kept in memory.
+     *
+     * @return size_t Bytes.
+     */
+    size_t memory() const;
+
+    /**
+     * @brief Get the number of operators found in memory or on disk.
+     *
+     * @return size_t
+     */
+    size_t hits() const;
+
+    /**
+     * @brief Get the number of operators built.
+     *
+     * @return size_t
+     */
+    size_t misses() const;
+};
+
+#endif // CACHE_H
@@ -12,26 +12,176 @@
 #ifndef COMPUTATION_H
 #define COMPUTATION_H
 
+#include <optional>
+#include <string>
 #include <vector>
 #include "bar.h"
+#include "grid.h"
+#include "stepping.h"
 #include "plate.h"
 
+/**
+ * @brief Options of a run.
+ * 
+ */
+struct RunOptions
+{
+    /**
+     * @brief File to write output, empty if none.
+     * 
+     */
+    std::string filename = "";
+    /**
+     * @brief If the GUI is not used. Output is then streamed to stdout.
+     * 
+     */
+    bool nogui = false;
+    /**
+     * @brief File to write output in the binary format, empty if none.
+     * 
+     */
+    std::string binaryFilename = "";
+    /**
+     * @brief If values are written as float32 in the binary file.
+     * 
+     */
+    bool singlePrecision = false;
+    /**
+     * @brief Number of significant digits of the text outputs, 0 for the shortest exact representation.
+     * 
+     */
+    int precision = 0;
+    /**
+     * @brief Number of threads formatting the text outputs.
+     * 
+     */
+    size_t formatThreads = 1;
+    /**
+     * @brief Number of steps which can wait to be written by each output thread, 0 to write from the solver thread.
+     * 
+     */
+    size_t pipelineDepth = 4;
+    /**
+     * @brief Job file of a sweep, empty if a single scenario is run.
+     * 
+     */
+    std::string sweepFilename = "";
+    /**
+     * @brief Number of scenarios of a sweep solved concurrently, 0 for one per hardware thread.
+     * 
+     */
+    size_t jobs = 0;
+    /**
+     * @brief Solve the plate on all the MPI ranks (see {@link solveDistributed}).
+     * 
+     */
+    bool distributed = false;
+    /**
+     * @brief Format of the profile reported at exit (see {@link Profiler}), table or json, empty if the run is not profiled.
+     * 
+     */
+    std::string profile = "";
+    /**
+     * @brief Chrome trace written at exit (see {@link TraceRecorder}), empty if the run is not traced.
+     * 
+     */
+    std::string traceFilename = "";
+    /**
+     * @brief Only one time step out of every is written or displayed.
+     * 
+     */
+    size_t every = 1;
+    /**
+     * @brief Number of time points.
+     * 
+     */
+    size_t nt = Grid::defaultTimePoints;
+    /**
+     * @brief Number of space points along x.
+     * 
+     */
+    size_t nx = Grid::defaultSpacePoints;
+    /**
+     * @brief Number of space points along y, 0 for as many as along x.
+     * 
+     */
+    size_t ny = 0;
+    /**
+     * @brief Tolerance of the adaptive time stepping, 0 for fixed time steps.
+     * 
+     */
+    double tolerance = 0;
+    /**
+     * @brief Time integration scheme, none for the default scheme of the model.
+     * 
+     */
+    std::optional<Scheme> scheme;
+    /**
+     * @brief Solver of the linear systems of the plate.
+     * 
+     */
+    LinearSolver solver = LinearSolver::Direct;
+    /**
+     * @brief Smoother of the multigrid cycles.
+     * 
+     */
+    Smoother smoother = Smoother::GaussSeidel;
+    /**
+     * @brief Number of explicit sub-steps per wavefront of the tiled stencil engine, 0 for automatic.
+     * 
+     */
+    size_t tileDepth = 0;
+    /**
+     * @brief Only compute the equilibrium temperature.
+     * 
+     */
+    bool steady = false;
+};
+
+/**
+ * @brief Build the grid of a bar.
+ * 
+ * @param bar Bar.
+ * @param options Options of the run (nt, nx).
+ * @return Grid 
+ */
+Grid makeGrid(const Bar &bar, const RunOptions& options);
+
+/**
+ * @brief Build the grid of a plate.
+ * 
+ * @param plate Plate.
+ * @param options Options of the run (nt, nx, ny).
+ * @return Grid 
+ */
+Grid makeGrid(const Plate &plate, const RunOptions& options);
+
+/**
+ * @brief Get the options of the solver.
+ * 
+ * @param options Options of the run.
+ * @return SolverOptions 
+ */
+SolverOptions makeSolverOptions(const RunOptions& options);
+
 /**
  * @brief Solve the bar.
+ * Time steps are streamed to the outputs, so that the whole history is only kept in memory when the GUI is used.
+ * Without the GUI, the console output is therefore written while solving, before "Solution computed.".
  * 
  * @param bar Bar to solve.
- * @param filename File to write output.
- * @param nogui If the GUI is used.
+ * @param options Options of the run.
  */
-void solveBar(const Bar &bar, const std::string& filename, bool nogui);
+void solveBar(const Bar &bar, const RunOptions& options);
 
 /**
  * @brief Solve the plate.
+ * Time steps are streamed to the outputs, so that the whole history is only kept in memory when the GUI is used.
+ * Without the GUI, the console output is therefore written while solving, before "Solution computed.".
  * 
  * @param plate Plate to solve.
- * @param filename File to write output.
- * @param nogui  If the GUI is used.
+ * @param options Options of the run.
  */
-void solvePlate(const Plate &plate, const std::string& filename, bool nogui);
+void solvePlate(const Plate &plate, const RunOptions& options);
 
 #endif // COMPUTATION_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file distributed.h
+ * @author Thomas Roiseux
+ * @brief Provides the distributed-memory solver of the plate, for builds with MPI (make MPI=TRUE).
+ * The plate is cut in one tile per rank, on a 2D Cartesian grid of ranks. Each rank only stores its
+ * tile and a one point halo, so a plate can be larger than the memory of a node.
+ * @version 0.1
+ * @date 2023-01-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <cstddef>
+#include <string>
+#include "grid.h"
+#include "plate.h"
+#include "stepping.h"
+
+/**
+ * @brief MPI environment of the process, initialized on construction and finalized on destruction.
+ * Only the main thread calls MPI, the team of the solvers only computes.
+ *
+ */
+class MpiSession
+{
+private:
+    int rankIndex;
+    int rankCount;
+public:
+    /**
+     * @brief Construct a new Mpi Session object.
+     *
+     * @param argc Number of arguments.
+     * @param argv Arguments.
+     * @throws Exn If MPI cannot be initialized.
+     */
+    MpiSession(int& argc, char**& argv);
+    MpiSession(const MpiSession&) = delete;
+    MpiSession& operator=(const MpiSession&) = delete;
+    /**
+     * @brief Destroy the Mpi Session object, finalizing MPI.
+     *
+     */
+    ~MpiSession();
+
+    /**
+     * @brief Get the rank of the process.
+     *
+     * @return int
+     */
+    int rank() const { return rankIndex; };
+
+    /**
+     * @brief Get the number of processes.
+     *
+     * @return int
+     */
+    int size() const { return rankCount; };
+};
+
+/**
+ * @brief Part of the plate owned by a rank: the points [x0, x0 + nx) x [y0, y0 + ny) of the grid.
+ *
+ */
+struct Tile
+{
+    size_t x0;
+    size_t nx;
+    size_t y0;
+    size_t ny;
+    /**
+     * @brief Ranks owning the tiles along -x, +x, -y and +y, MPI_PROC_NULL on the border of the plate.
+     *
+     */
+    int west;
+    int east;
+    int south;
+    int north;
+};
+
+/**
+ * @brief Solve the plate with the explicit scheme (see {@link Scheme::Explicit}) on all the ranks of
+ * MPI_COMM_WORLD. Each sub-step exchanges the halos of the tiles with non-blocking messages, while the
+ * inner points of the tiles are computed. Must be called by all the ranks.
+ *
+ * @param plate Plate.
+ * @param grid Grid.
+ * @param binaryFilename Binary file written collectively with MPI-IO (see {@link BinaryWriter}), empty if none.
+ * @param singlePrecision If values are written as float32 instead of float64.
+ * @param options Options of the solver, only every is used.
+ * @return StepStats
+ * @throws Exn If a rank would own no point.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+StepStats solveDistributed(const Plate& plate, const Grid& grid, const std::string& binaryFilename, bool singlePrecision, const SolverOptions& options);
+
+#endif // DISTRIBUTED_H
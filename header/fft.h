@@ -0,0 +1,67 @@
+/**
+ * @file fft.h
+ * @author Thomas Roiseux
+ * @brief Provides the fast Fourier transform, and the {@link SineTransform} class built on it.
+ * @version 0.1
+ * @date 2023-01-12
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief In-place radix-2 fast Fourier transform, X_k = sum_j x_j exp(-2 i pi j k / n).
+ *
+ * @param a Values, their number must be a power of 2.
+ * @param inverse Compute the inverse transform (with the 1 / n factor) instead.
+ * @throws Exn If the size is not a power of 2.
+ */
+void fft(std::vector<std::complex<double>>& a, bool inverse = false);
+
+/**
+ * @brief Discrete sine transform of type I, y_m = sum_j x_j sin(pi (j + 1) (m + 1) / (n + 1)), for any n.
+ * It is computed through a Fourier transform of size 2 (n + 1), with Bluestein's algorithm when that
+ * size is not a power of 2, so its cost is O(n log n). The transform is its own inverse, up to a 2 / (n + 1) factor.
+ *
+ */
+class SineTransform
+{
+private:
+    size_t n;
+    size_t m;
+    size_t size;
+    std::vector<std::complex<double>> chirp;
+    std::vector<std::complex<double>> kernel;
+public:
+    /**
+     * @brief Construct a new Sine Transform object.
+     *
+     * @param n Number of values.
+     */
+    explicit SineTransform(size_t n);
+
+    /**
+     * @brief Get the number of values.
+     *
+     * @return size_t
+     */
+    size_t length() const { return n; };
+
+    /**
+     * @brief Transform values in place.
+     *
+     * @param x Values, the value j being x[j * stride].
+     * @param stride Distance between two values.
+     * @param work Work buffer, resized as needed. Concurrent calls need their own buffer.
+     */
+    void apply(double* x, size_t stride, std::vector<std::complex<double>>& work) const;
+};
+
+#endif // FFT_H
@@ -0,0 +1,143 @@
+/**
+ * @file grid.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link Grid} class, the discretization in time and space of a model.
+ * @version 0.1
+ * @date 2023-01-10
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Uniform sampling of [0, length]: the point i is i * step.
+ *
+ */
+class Axis
+{
+private:
+    double length;
+    double spacing;
+    std::vector<double> values;
+public:
+    /**
+     * @brief Construct an empty Axis object.
+     *
+     */
+    Axis();
+
+    /**
+     * @brief Construct a new Axis object.
+     *
+     * @param length Length of the axis.
+     * @param n Number of points, including both ends.
+     * @throws Exn If there are less than 2 points.
+     */
+    Axis(double length, size_t n);
+
+    /**
+     * @brief Get the number of points.
+     *
+     * @return size_t
+     */
+    size_t size() const { return values.size(); };
+
+    /**
+     * @brief Check if the axis has no point.
+     *
+     * @return true The axis is empty.
+     * @return false The axis has points.
+     */
+    bool empty() const { return values.empty(); };
+
+    /**
+     * @brief Get the distance between two consecutive points.
+     *
+     * @return double
+     */
+    double step() const { return spacing; };
+
+    /**
+     * @brief Get the length of the axis.
+     *
+     * @return double
+     */
+    double getLength() const { return length; };
+
+    /**
+     * @brief Get a point.
+     *
+     * @param i Index of the point.
+     * @return double
+     */
+    double operator[](size_t i) const { return values[i]; };
+
+    /**
+     * @brief Get all the points.
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& points() const { return values; };
+};
+
+/**
+ * @brief Discretization of a model: time, and one (bar) or two (plate) space axes.
+ *
+ */
+class Grid
+{
+public:
+    /**
+     * @brief Default number of time points.
+     *
+     */
+    static constexpr size_t defaultTimePoints = 1001;
+    /**
+     * @brief Default number of space points along each axis.
+     *
+     */
+    static constexpr size_t defaultSpacePoints = 1001;
+
+    /**
+     * @brief Time points.
+     *
+     */
+    Axis time;
+    /**
+     * @brief Space points along x.
+     *
+     */
+    Axis x;
+    /**
+     * @brief Space points along y, empty for a bar.
+     *
+     */
+    Axis y;
+
+    /**
+     * @brief Construct an empty Grid object.
+     *
+     */
+    Grid();
+
+    /**
+     * @brief Construct a new Grid object.
+     *
+     * @param tMax Max time.
+     * @param nt Number of time points.
+     * @param L Length along x.
+     * @param nx Number of points along x.
+     * @param W Length along y.
+     * @param ny Number of points along y, 0 for a bar.
+     * @throws Exn If an axis has less than 2 points.
+     */
+    Grid(double tMax, size_t nt, double L, size_t nx, double W = 0, size_t ny = 0);
+};
+
+#endif // GRID_H
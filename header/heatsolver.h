@@ -0,0 +1,646 @@
+/**
+ * @file heatsolver.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link HeatSolver} class, the time loop of the bar and of the plate,
+ * specialized at compile time on the dimension, the scheme and the precision.
+ * @version 0.1
+ * @date 2023-01-19
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef HEATSOLVER_H
+#define HEATSOLVER_H
+
+#include "exn.h"
+#include "grid.h"
+#include "parallel.h"
+#include "profile.h"
+#include "sink.h"
+#include "stencil.h"
+#include "stepping.h"
+#include "tiling.h"
+#include "workspace.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Factorized tridiagonal matrix (see {@link triDecomp}), read in place: element i of each array is
+ * at index i * stride, so that the band storage of a {@link BandedMatrix} is read without a copy.
+ *
+ * @tparam Real Type of the values.
+ */
+template <typename Real>
+struct TridiagonalView
+{
+    /**
+     * @brief Multipliers of the lower triangular matrix.
+     *
+     */
+    const Real *lower;
+    /**
+     * @brief Diagonal of the upper triangular matrix.
+     *
+     */
+    const Real *diagonal;
+    /**
+     * @brief Upper diagonal of the matrix.
+     *
+     */
+    const Real *upper;
+    size_t stride;
+    size_t n;
+};
+
+/**
+ * @brief Copy of a factorized tridiagonal matrix in another precision.
+ *
+ * @tparam Real Type of the values.
+ */
+template <typename Real>
+struct TridiagonalCopy
+{
+    std::vector<Real> lower;
+    std::vector<Real> diagonal;
+    std::vector<Real> upper;
+
+    /**
+     * @brief Construct a new Tridiagonal Copy object.
+     *
+     * @param view Matrix to copy.
+     */
+    explicit TridiagonalCopy(const TridiagonalView<double>& view) : lower(view.n), diagonal(view.n), upper(view.n)
+    {
+        for (size_t i = 0; i < view.n; i++)
+        {
+            lower[i] = static_cast<Real>(view.lower[i * view.stride]);
+            diagonal[i] = static_cast<Real>(view.diagonal[i * view.stride]);
+            upper[i] = static_cast<Real>(view.upper[i * view.stride]);
+        }
+    };
+
+    /**
+     * @brief Get a view of the copy.
+     *
+     * @return TridiagonalView<Real>
+     */
+    TridiagonalView<Real> view() const { return {lower.data(), diagonal.data(), upper.data(), 1, diagonal.size()}; };
+};
+
+/**
+ * @brief Solve in place several tridiagonal systems sharing a matrix, with the arithmetic of {@link triSolve}.
+ * Element i of system c is stored at index i * stride + c.
+ *
+ * @tparam Real Type of the values.
+ * @param A Factorized matrix.
+ * @param x Right-hand sides, replaced by the solutions.
+ * @param count Number of systems.
+ * @param stride Distance between two elements of a system.
+ */
+template <typename Real>
+void solveTridiagonal(const TridiagonalView<Real>& A, Real* x, size_t count, size_t stride)
+{
+    Profiler::count(Counter::Solves);
+    const size_t n = A.n;
+    if (n == 0)
+    {
+        return;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        const Real li = A.lower[i * A.stride];
+        Real *xi = x + i * stride;
+        const Real *xPrev = xi - stride;
+        for (size_t c = 0; c < count; c++)
+        {
+            xi[c] = xi[c] - li * xPrev[c];
+        }
+    }
+
+    const Real uLast = A.diagonal[(n - 1) * A.stride];
+    Real *xLast = x + (n - 1) * stride;
+    for (size_t c = 0; c < count; c++)
+    {
+        xLast[c] /= uLast;
+    }
+    for (size_t i = n - 1; i >= 1; i--)
+    {
+        const Real ci = A.upper[(i - 1) * A.stride];
+        const Real ui = A.diagonal[(i - 1) * A.stride];
+        Real *xi = x + (i - 1) * stride;
+        const Real *xNext = xi + stride;
+        for (size_t c = 0; c < count; c++)
+        {
+            xi[c] = (xi[c] - ci * xNext[c]) / ui;
+        }
+    }
+}
+
+/**
+ * @brief Solve in place one contiguous tridiagonal system.
+ *
+ * @tparam Real Type of the values.
+ * @param A Factorized matrix.
+ * @param x Right-hand side, replaced by the solution.
+ */
+template <typename Real>
+void solveTridiagonal(const TridiagonalView<Real>& A, Real* x)
+{
+    Profiler::count(Counter::Solves);
+    const size_t n = A.n;
+    if (n == 0)
+    {
+        return;
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        x[i] = x[i] - A.lower[i * A.stride] * x[i - 1];
+    }
+    x[n - 1] /= A.diagonal[(n - 1) * A.stride];
+    for (size_t i = n - 1; i >= 1; i--)
+    {
+        x[i - 1] = (x[i - 1] - A.upper[(i - 1) * A.stride] * x[i]) / A.diagonal[(i - 1) * A.stride];
+    }
+}
+
+/**
+ * @brief Coefficients of an implicit scheme.
+ *
+ * @tparam S Scheme.
+ */
+template <Scheme S>
+struct SchemeCoefficients;
+
+template <>
+struct SchemeCoefficients<Scheme::Euler>
+{
+    /**
+     * @brief Factor of the 1 / dt term of the right-hand side.
+     *
+     */
+    static constexpr int timeFactor = 1;
+    /**
+     * @brief If the right-hand side holds the explicit half of the operator.
+     *
+     */
+    static constexpr bool explicitPart = false;
+};
+
+template <>
+struct SchemeCoefficients<Scheme::CrankNicolson>
+{
+    static constexpr int timeFactor = 2;
+    static constexpr bool explicitPart = true;
+};
+
+/**
+ * @brief Axis of a {@link HeatSolver}.
+ *
+ * @tparam Real Type of the values.
+ */
+template <typename Real>
+struct HeatAxis
+{
+    /**
+     * @brief Factorized operator along the axis (see {@link Bar::operatorStep} and {@link Plate::operatorStep}).
+     * The explicit scheme only uses its number of points.
+     *
+     */
+    TridiagonalView<Real> system;
+    /**
+     * @brief Diffusivity divided by the square of the step along the axis.
+     *
+     */
+    Real b;
+};
+
+/**
+ * @brief Time loop of the heat equation on a line (Dim = 1, the bar) or on a rectangle (Dim = 2, the plate),
+ * with the values on the edges held at u0. Each combination of dimension, scheme and precision is a separate
+ * class, so the steps are compiled with their coefficients and without any indirection.
+ *
+ * The bar solves A next = rhs with the operator A of {@link Bar::makeOperator}, and the plate splits each
+ * step by direction (see {@link Plate::makeAdiOperator}): Crank-Nicolson is the Peaceman-Rachford scheme,
+ * and implicit Euler is the Lie splitting. The explicit scheme splits each step in stable sub-steps, run
+ * on the stencil engines, in double precision.
+ *
+ * The implicit bar can advance several bars sharing their operator at once, one lane per bar: the value of
+ * point j of lane c is stored at j * lanes + c, and so are the boundary and source terms.
+ *
+ * The solver references its operators and its boundary and source terms, which must outlive it.
+ *
+ * @tparam Dim Number of dimensions, 1 or 2.
+ * @tparam S Scheme.
+ * @tparam Real Type of the values, float or double.
+ */
+template <size_t Dim, Scheme S, typename Real>
+class HeatSolver
+{
+    static_assert(Dim == 1 || Dim == 2, "The heat solver handles the bar and the plate.");
+    static_assert(std::is_floating_point_v<Real>, "The values must be floating point.");
+    static_assert(S != Scheme::Explicit || std::is_same_v<Real, double>, "The stencil engines are in double precision.");
+
+    using Buffer = std::vector<Real, UninitializedAllocator<Real>>;
+private:
+    std::array<HeatAxis<Real>, Dim> axes;
+    Real u0;
+    const Real *boundary;
+    const Real *source;
+    size_t lanes;
+    size_t tileDepth;
+    Workspace workspace;
+
+    /**
+     * @brief Advance the bar by one step. Implicit Euler solves A next = -cur / dt + B + C. Crank-Nicolson,
+     * with L the operator without its diagonal 1 / dt term, solves (L / 2 - I / dt) next = -cur / dt - L cur / 2 + B + C
+     * multiplied by 2, whose matrix is the implicit Euler operator for dt / 2. The explicit scheme takes
+     * sub-steps h: next = cur + h (b (left - 2 cur + right) - C), the values outside of the bar being u0.
+     *
+     * @param dt Time step.
+     * @param cur Current values.
+     * @param work Work values of the explicit sub-steps.
+     * @param next Next values, may be cur if there is one lane.
+     */
+    void stepLine(Real dt, const Real* cur, Real* work, Real* next)
+    {
+        const size_t n = axes[0].system.n;
+        const Real b = axes[0].b;
+        if constexpr (S == Scheme::Explicit)
+        {
+            const size_t subSteps = explicitSubSteps(dt, 1 / (2 * b));
+            const double h = dt / subSteps;
+            if (cur != next)
+            {
+                std::copy(cur, cur + n, next);
+            }
+            double *values = next;
+            for (size_t s = 0; s < subSteps; s++)
+            {
+                stencil3(values, work, n, 1 - 2 * b * h, b * h, u0, u0);
+                for (size_t j = 0; j < n; j++)
+                {
+                    work[j] -= h * source[j];
+                }
+                std::swap(values, work);
+            }
+            if (values != next)
+            {
+                std::copy(values, values + n, next);
+            }
+            return;
+        }
+        else
+        {
+            using Coefficients = SchemeCoefficients<S>;
+            if constexpr (Coefficients::explicitPart)
+            {
+                if (lanes == 1)
+                {
+                    Real left = 0;
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        // cur[j] and cur[j + 1] are read before next[j] is written, so that next may be cur.
+                        const Real center = cur[j];
+                        const Real right = j < n - 1 ? cur[j + 1] : 0;
+                        next[j] = -Coefficients::timeFactor * center / dt - b * (left - 2 * center + right) + Coefficients::timeFactor * (boundary[j] + source[j]);
+                        left = center;
+                    }
+                }
+                else
+                {
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        const Real *left = j > 0 ? cur + (j - 1) * lanes : nullptr;
+                        const Real *center = cur + j * lanes;
+                        const Real *right = j < n - 1 ? cur + (j + 1) * lanes : nullptr;
+                        const Real *bj = boundary + j * lanes;
+                        const Real *cj = source + j * lanes;
+                        Real *out = next + j * lanes;
+                        for (size_t c = 0; c < lanes; c++)
+                        {
+                            const Real l = left ? left[c] : 0;
+                            const Real e = right ? right[c] : 0;
+                            out[c] = -Coefficients::timeFactor * center[c] / dt - b * (l - 2 * center[c] + e) + Coefficients::timeFactor * (bj[c] + cj[c]);
+                        }
+                    }
+                }
+            }
+            else
+            {
+                for (size_t j = 0; j < n * lanes; j++)
+                {
+                    next[j] = -cur[j] / dt + boundary[j] + source[j];
+                }
+            }
+            if (lanes == 1)
+            {
+                solveTridiagonal(axes[0].system, next);
+            }
+            else
+            {
+                solveTridiagonal(axes[0].system, next, lanes, lanes);
+            }
+        }
+    }
+
+    /**
+     * @brief Advance the plate by one step. The implicit schemes are implicit along x then along y: the
+     * Crank-Nicolson half steps are explicit along the other direction, the implicit Euler steps are implicit
+     * for the whole step along each direction, so their systems are the ones of a Peaceman-Rachford step for
+     * 2 dt. The explicit sub-steps h, next = cur + h ((Lx + Ly) cur + C), run on the tiled stencil engine.
+     *
+     * @param dt Time step.
+     * @param cur Current values, nx * ny.
+     * @param half Values after the step along x, or work values of the explicit sub-steps, nx * ny.
+     * @param next Next values, nx * ny, may be cur.
+     */
+    void stepRectangle(Real dt, const Real* cur, Real* half, Real* next)
+    {
+        const size_t nx = axes[0].system.n;
+        const size_t ny = axes[1].system.n;
+        const Real bx = axes[0].b;
+        const Real by = axes[1].b;
+
+        if constexpr (S == Scheme::Explicit)
+        {
+            const size_t subSteps = explicitSubSteps(dt, 1 / (2 * (bx + by)));
+            const double h = dt / subSteps;
+            if (cur != next)
+            {
+                std::copy(cur, cur + nx * ny, next);
+            }
+            tiledStencil5(next, half, nx, ny, 1 - 2 * h * (bx + by), h * bx, h * by, u0, source, h, subSteps, workspace, tileDepth);
+            return;
+        }
+        else
+        {
+            using Coefficients = SchemeCoefficients<S>;
+            const Real r = Coefficients::timeFactor / dt;
+
+            // Implicit along x: the lines k of a block are solved together, row j after row j.
+            parallelFor(ny, [&](size_t kBegin, size_t kEnd)
+            {
+                for (size_t j = 0; j < nx; j++)
+                {
+                    const Real *row = cur + j * ny;
+                    for (size_t k = kBegin; k < kEnd; k++)
+                    {
+                        Real value;
+                        if constexpr (Coefficients::explicitPart)
+                        {
+                            const Real south = k > 0 ? row[k - 1] : u0;
+                            const Real north = k < ny - 1 ? row[k + 1] : u0;
+                            value = r * row[k] + by * (south - 2 * row[k] + north) + source[j * ny + k];
+                        }
+                        else
+                        {
+                            value = r * row[k] + source[j * ny + k];
+                        }
+                        if (j == 0 || j == nx - 1)
+                        {
+                            value += bx * u0;
+                        }
+                        half[j * ny + k] = value;
+                    }
+                }
+                solveTridiagonal(axes[0].system, half + kBegin, kEnd - kBegin, ny);
+            });
+
+            // Implicit along y: each row j is a contiguous system.
+            parallelFor(nx, [&](size_t jBegin, size_t jEnd)
+            {
+                for (size_t j = jBegin; j < jEnd; j++)
+                {
+                    const Real *row = half + j * ny;
+                    Real *out = next + j * ny;
+                    if constexpr (Coefficients::explicitPart)
+                    {
+                        const Real *west = j > 0 ? row - ny : nullptr;
+                        const Real *east = j < nx - 1 ? row + ny : nullptr;
+                        for (size_t k = 0; k < ny; k++)
+                        {
+                            const Real w = west ? west[k] : u0;
+                            const Real e = east ? east[k] : u0;
+                            Real value = r * row[k] + bx * (w - 2 * row[k] + e) + source[j * ny + k];
+                            if (k == 0 || k == ny - 1)
+                            {
+                                value += by * u0;
+                            }
+                            out[k] = value;
+                        }
+                    }
+                    else
+                    {
+                        for (size_t k = 0; k < ny; k++)
+                        {
+                            out[k] = r * row[k];
+                        }
+                        out[0] += by * u0;
+                        out[ny - 1] += by * u0;
+                    }
+                    solveTridiagonal(axes[1].system, out);
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Fill a buffer, first touching each page on the thread which computes on it the most
+     * (see {@link firstTouch}). The implicit steps of the plate spend most of their memory traffic in the
+     * sweep along x, which solves blocks of columns: each thread touches its block of columns of every row,
+     * as the sweep does. The explicit sub-steps of the plate work on blocks of rows. The bar is solved by one
+     * thread.
+     *
+     * @param buffer Buffer.
+     * @param value Value.
+     */
+    void touch(Buffer& buffer, Real value) const
+    {
+        buffer.resize(size());
+        Real *data = buffer.data();
+        if constexpr (Dim == 1)
+        {
+            std::fill(data, data + buffer.size(), value);
+        }
+        else if constexpr (S == Scheme::Explicit)
+        {
+            const size_t rowSize = axes[1].system.n;
+            parallelFor(axes[0].system.n, [&](size_t begin, size_t end)
+            {
+                std::fill(data + begin * rowSize, data + end * rowSize, value);
+            });
+        }
+        else
+        {
+            const size_t nx = axes[0].system.n;
+            const size_t ny = axes[1].system.n;
+            parallelFor(ny, [&](size_t kBegin, size_t kEnd)
+            {
+                for (size_t j = 0; j < nx; j++)
+                {
+                    std::fill(data + j * ny + kBegin, data + j * ny + kEnd, value);
+                }
+            });
+        }
+    }
+public:
+    /**
+     * @brief Construct a new Heat Solver object.
+     *
+     * @param axes Operator of each axis, x first.
+     * @param u0 Temperature of the edges.
+     * @param boundary Boundary term of the implicit bar (see {@link Bar::makeRightHandSide}), unused otherwise.
+     * @param source Source term, divided by rho * cp, point (j, k) of the plate being stored at j * ny + k.
+     * @param lanes Number of bars advanced at once, by the implicit schemes.
+     * @param tileDepth Number of explicit sub-steps per wavefront of the plate, 0 to choose it from the grid.
+     * @throws Exn if there are several lanes for the plate or for the explicit scheme.
+     */
+    HeatSolver(const std::array<HeatAxis<Real>, Dim>& axes, Real u0, const Real* boundary, const Real* source, size_t lanes = 1, size_t tileDepth = 0)
+        : axes(axes), u0(u0), boundary(boundary), source(source), lanes(lanes), tileDepth(tileDepth)
+    {
+        if (lanes == 0 || (lanes > 1 && (Dim != 1 || S == Scheme::Explicit)))
+        {
+            throw Exn("Only the implicit bar has lanes.");
+        }
+    };
+
+    /**
+     * @brief Use the operators of another time step, for adaptive steps.
+     *
+     * @param axes Operator of each axis, with the same number of points.
+     */
+    void setAxes(const std::array<HeatAxis<Real>, Dim>& axes) { this->axes = axes; };
+
+    /**
+     * @brief Get the number of values, of all the lanes.
+     *
+     * @return size_t
+     */
+    size_t size() const
+    {
+        size_t n = lanes;
+        for (const HeatAxis<Real> &axis : axes)
+        {
+            n *= axis.system.n;
+        }
+        return n;
+    };
+
+    /**
+     * @brief Advance by one step. The operators must be the ones of this step.
+     *
+     * @param dt Time step.
+     * @param cur Current values.
+     * @param half Intermediate values: after the step along x for the plate, work values of the explicit
+     * sub-steps, unused by the implicit bar.
+     * @param next Next values, may be cur if there is one lane.
+     */
+    void step(Real dt, const Real* cur, Real* half, Real* next)
+    {
+        if constexpr (Dim == 1)
+        {
+            stepLine(dt, cur, half, next);
+        }
+        else
+        {
+            stepRectangle(dt, cur, half, next);
+        }
+    };
+
+    /**
+     * @brief Solve over the time grid, streaming the steps of each lane to its sink (every 'every' steps,
+     * and the last one). Values in single precision are widened before they are streamed.
+     *
+     * @param grid Grid, whose steps match the operators.
+     * @param sinks Sink of each lane.
+     * @param every Stride between streamed steps.
+     * @param initial Initial values, u0 everywhere if null.
+     * @throws Exn if there is not one sink per lane.
+     */
+    void run(const Grid& grid, const std::vector<StepSink*>& sinks, size_t every, const Real* initial = nullptr)
+    {
+        if (sinks.size() != lanes)
+        {
+            throw Exn("The solver needs one sink per lane.");
+        }
+        const std::vector<double> &time = grid.time.points();
+        const size_t nt = time.size();
+        const size_t nx = axes[0].system.n;
+        const size_t ny = Dim == 2 ? axes[1].system.n : 1;
+        const Real dt = static_cast<Real>(grid.time.step());
+
+        ScopedPhase phase("time loop");
+        Buffer cur, next, half;
+        touch(cur, u0);
+        touch(next, 0);
+        if constexpr (Dim == 2 || S == Scheme::Explicit)
+        {
+            touch(half, 0);
+        }
+        if (initial)
+        {
+            std::copy(initial, initial + size(), cur.begin());
+        }
+        // Values of a lane, when they are not streamed from the solver buffer.
+        const bool direct = std::is_same_v<Real, double> && lanes == 1;
+        std::vector<double> laneValues(direct ? 0 : nx * ny);
+        auto stream = [&](size_t i)
+        {
+            for (size_t c = 0; c < lanes; c++)
+            {
+                const double *values = laneValues.data();
+                if constexpr (std::is_same_v<Real, double>)
+                {
+                    if (direct)
+                    {
+                        values = cur.data();
+                    }
+                }
+                if (!direct)
+                {
+                    for (size_t j = 0; j < nx * ny; j++)
+                    {
+                        laneValues[j] = cur[j * lanes + c];
+                    }
+                }
+                sinks[c]->consume(i, time[i], ConstStepView(values, nx, ny));
+            }
+        };
+        for (StepSink *sink : sinks)
+        {
+            sink->begin(streamedSteps(nt, every), grid.x.points(), grid.y.points());
+        }
+        stream(0);
+        for (size_t i = 0; i < nt - 1; i++)
+        {
+            ScopedPhase stepPhase("step");
+            step(dt, cur.data(), half.data(), next.data());
+            cur.swap(next);
+            if (isStreamed(i + 1, nt, every))
+            {
+                stream(i + 1);
+            }
+        }
+        for (StepSink *sink : sinks)
+        {
+            sink->end();
+        }
+        Profiler::count(Counter::Steps, (nt - 1) * lanes);
+    };
+
+    /**
+     * @brief Solve one lane over the time grid, streaming its steps to a sink (see {@link run}).
+     *
+     * @param grid Grid, whose steps match the operators.
+     * @param sink Sink of the steps.
+     * @param every Stride between streamed steps.
+     */
+    void run(const Grid& grid, StepSink& sink, size_t every) { run(grid, std::vector<StepSink*>{&sink}, every); };
+};
+
+#endif // HEATSOLVER_H
@@ -0,0 +1,303 @@
+/**
+ * @file matrix.h
+ * @author Thomas Roiseux
+ * @brief Provides the matrix types used by the solvers: dense, banded and CSR.
+ * @version 0.1
+ * @date 2023-01-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief Common interface of all the matrix types.
+ *
+ */
+class Matrix
+{
+protected:
+    size_t nRows;
+    size_t nCols;
+public:
+    /**
+     * @brief Construct a new Matrix object.
+     *
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     */
+    Matrix(size_t rows, size_t cols);
+    /**
+     * @brief Destroy the Matrix object.
+     *
+     */
+    virtual ~Matrix();
+    Matrix(const Matrix&) = default;
+    Matrix& operator=(const Matrix&) = default;
+
+    /**
+     * @brief Get the number of rows.
+     *
+     * @return size_t
+     */
+    size_t rows() const { return nRows; };
+
+    /**
+     * @brief Get the number of columns.
+     *
+     * @return size_t
+     */
+    size_t cols() const { return nCols; };
+
+    /**
+     * @brief Get a coefficient. Coefficients which are not stored are zero.
+     *
+     * @param i Row.
+     * @param j Column.
+     * @return double
+     */
+    virtual double operator()(size_t i, size_t j) const = 0;
+
+    /**
+     * @brief Computes y = A x.
+     *
+     * @param x Vector.
+     * @param y Result.
+     * @throws Exn if x does not have as many elements as the matrix has columns.
+     */
+    virtual void multiply(const std::vector<double>& x, std::vector<double>& y) const = 0;
+
+    /**
+     * @brief Get the memory used to store the coefficients.
+     *
+     * @return size_t Size in bytes.
+     */
+    virtual size_t memory() const = 0;
+};
+
+/**
+ * @brief Dense matrix, stored contiguously in row-major order.
+ *
+ */
+class DenseMatrix : public Matrix
+{
+private:
+    std::vector<double> data;
+public:
+    /**
+     * @brief Construct a new Dense Matrix object filled with zeros.
+     *
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     */
+    explicit DenseMatrix(size_t rows = 0, size_t cols = 0);
+
+    double operator()(size_t i, size_t j) const override { return data[i * nCols + j]; };
+
+    /**
+     * @brief Get a reference to a coefficient.
+     *
+     * @param i Row.
+     * @param j Column.
+     * @return double&
+     */
+    double& at(size_t i, size_t j) { return data[i * nCols + j]; };
+
+    /**
+     * @brief Get a pointer to the first coefficient of a row.
+     *
+     * @param i Row.
+     * @return const double*
+     */
+    const double* row(size_t i) const { return data.data() + i * nCols; };
+
+    void multiply(const std::vector<double>& x, std::vector<double>& y) const override;
+
+    size_t memory() const override { return data.size() * sizeof(double); };
+};
+
+/**
+ * @brief Band matrix with kl sub-diagonals and ku super-diagonals.
+ * Row i stores the coefficients of columns i - kl to i + ku contiguously.
+ * The matrix can be factorized in place (LU without pivoting, suited to the
+ * diagonally dominant operators of the heat equation) and then solved in O(n (kl + ku)).
+ *
+ */
+class BandedMatrix : public Matrix
+{
+private:
+    size_t kl;
+    size_t ku;
+    std::vector<double> data;
+    bool factorized;
+public:
+    /**
+     * @brief Construct a new Banded Matrix object filled with zeros.
+     *
+     * @param n Size of the (square) matrix.
+     * @param kl Number of sub-diagonals.
+     * @param ku Number of super-diagonals.
+     */
+    explicit BandedMatrix(size_t n = 0, size_t kl = 1, size_t ku = 1);
+
+    /**
+     * @brief Get the number of sub-diagonals.
+     *
+     * @return size_t
+     */
+    size_t lowerBandwidth() const { return kl; };
+
+    /**
+     * @brief Get the number of super-diagonals.
+     *
+     * @return size_t
+     */
+    size_t upperBandwidth() const { return ku; };
+
+    /**
+     * @brief Check if the matrix holds its LU factors.
+     *
+     * @return true The matrix has been factorized.
+     * @return false The matrix holds its coefficients.
+     */
+    bool isFactorized() const { return factorized; };
+
+    /**
+     * @brief Get the band storage: the band of row i, from column i - kl to column i + ku, starts at index
+     * i * (kl + ku + 1).
+     *
+     * @return const double*
+     */
+    const double* band() const { return data.data(); };
+
+    double operator()(size_t i, size_t j) const override;
+
+    /**
+     * @brief Set a coefficient.
+     *
+     * @param i Row.
+     * @param j Column.
+     * @param value Value.
+     * @throws Exn if (i, j) is outside the band or if the matrix is factorized.
+     */
+    void set(size_t i, size_t j, double value);
+
+    void multiply(const std::vector<double>& x, std::vector<double>& y) const override;
+
+    size_t memory() const override { return data.size() * sizeof(double); };
+
+    /**
+     * @brief Replace the coefficients by their LU factors. The band is preserved since there is no pivoting.
+     * @throws Exn if a pivot is zero.
+     */
+    void factorize();
+
+    /**
+     * @brief Solves A x = b, using the factors computed by {@link factorize}.
+     *
+     * @param b Right-hand side.
+     * @param x Solution.
+     * @throws Exn if the matrix is not factorized or if sizes do not match.
+     */
+    void solve(const std::vector<double>& b, std::vector<double>& x) const;
+
+    /**
+     * @brief Solves A x = b, using the factors computed by {@link factorize}.
+     * b and x must hold as many values as the matrix has rows; x may be equal to b.
+     *
+     * @param b Right-hand side.
+     * @param x Solution.
+     * @throws Exn if the matrix is not factorized.
+     */
+    void solve(const double* b, double* x) const;
+
+    /**
+     * @brief Solves A x = b for count right-hand sides at once, using the factors computed by {@link factorize}.
+     * Element i of system c is stored at index i * stride + c, so that the innermost loop runs over the systems.
+     * Each system gets the same result as with a single right-hand side; x may be equal to b.
+     * @param b Right-hand sides.
+     * @param x Solutions.
+     * @param count Number of systems.
+     * @param stride Distance between two consecutive elements of a system, at least count.
+     * @throws Exn if the matrix is not factorized.
+     */
+    void solve(const double* b, double* x, size_t count, size_t stride) const;
+
+    /**
+     * @brief Write the matrix, in native byte order.
+     *
+     * @param out Binary stream.
+     */
+    void write(std::ostream& out) const;
+
+    /**
+     * @brief Replace the matrix by one written by {@link write}.
+     *
+     * @param in Binary stream.
+     * @throws Exn If the stream does not hold a banded matrix.
+     */
+    void read(std::istream& in);
+};
+
+/**
+ * @brief Coefficient used to assemble a {@link CsrMatrix}.
+ *
+ */
+struct Triplet
+{
+    size_t row;
+    size_t col;
+    double value;
+};
+
+/**
+ * @brief Sparse matrix in compressed sparse row format.
+ *
+ */
+class CsrMatrix : public Matrix
+{
+private:
+    std::vector<size_t> rowPtr;
+    std::vector<size_t> colIdx;
+    std::vector<double> values;
+public:
+    /**
+     * @brief Construct an empty Csr Matrix object.
+     *
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     */
+    explicit CsrMatrix(size_t rows = 0, size_t cols = 0);
+    /**
+     * @brief Construct a new Csr Matrix object from its coefficients.
+     * Duplicated coefficients are summed.
+     *
+     * @param rows Number of rows.
+     * @param cols Number of columns.
+     * @param triplets Coefficients, in any order.
+     * @throws Exn if a coefficient is out of the matrix.
+     */
+    CsrMatrix(size_t rows, size_t cols, std::vector<Triplet> triplets);
+
+    /**
+     * @brief Get the number of stored coefficients.
+     *
+     * @return size_t
+     */
+    size_t nonZeros() const { return values.size(); };
+
+    double operator()(size_t i, size_t j) const override;
+
+    void multiply(const std::vector<double>& x, std::vector<double>& y) const override;
+
+    size_t memory() const override { return values.size() * (sizeof(double) + sizeof(size_t)) + rowPtr.size() * sizeof(size_t); };
+};
+
+#endif // MATRIX_H
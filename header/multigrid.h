@@ -0,0 +1,232 @@
+/**
+ * @file multigrid.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link Multigrid} class, a matrix-free geometric multigrid solver for the plate.
+ * @version 0.1
+ * @date 2023-01-13
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "stencil.h"
+#include "workspace.h"
+
+/**
+ * @brief Smoother of the multigrid cycles.
+ *
+ */
+enum class Smoother
+{
+    /**
+     * @brief Red-black Gauss-Seidel.
+     *
+     */
+    GaussSeidel,
+    /**
+     * @brief Weighted Jacobi (omega = 4 / 5), run on the temporally tiled stencil engine (see {@link jacobiSweeps}).
+     *
+     */
+    Jacobi
+};
+
+/**
+ * @brief Parse the name of a smoother: "gs" or "jacobi".
+ *
+ * @param name Name.
+ * @return Smoother
+ * @throws Exn If the name is unknown.
+ */
+Smoother parseSmoother(const std::string& name);
+
+/**
+ * @brief Solves A x = b, with A = shift I - Lx - Ly the 5-point operator of a nx x ny grid
+ * (Lx = bx [1 -2 1] along x, Ly = by [1 -2 1] along y) and x = 0 outside of the grid.
+ * The point (j, k) is stored at j * ny + k, as in {@link Solution}.
+ *
+ * The matrix is never assembled. Each level has half as many points as the finer one along the axes
+ * with a strong coupling (until 3 points), and the coarse operators are the same stencil for the coarse spacing.
+ * The transfers interpolate linearly between the coordinates of the points, so that any size works,
+ * and the smoother is red-black Gauss-Seidel or weighted Jacobi. The coarsest level is solved with a banded LU.
+ * A V-cycle is symmetric, so that it can precondition the conjugate gradient.
+ * Every step of a cycle runs on blocks of rows of the team of the solvers (see {@link parallelFor}).
+ *
+ */
+class Multigrid : public LinearOperator
+{
+private:
+    /**
+     * @brief A level of the hierarchy, and how it maps to the next coarser one.
+     *
+     */
+    struct Level
+    {
+        size_t nx;
+        size_t ny;
+        double bx;
+        double by;
+        std::vector<double> x;
+        std::vector<double> b;
+        std::vector<double> r;
+        /**
+         * @brief For each point along x, the coarse point on its left (-1 outside of the grid)
+         * and the weight of the coarse point on its right.
+         *
+         */
+        std::vector<long> leftX;
+        std::vector<double> weightX;
+        std::vector<long> leftY;
+        std::vector<double> weightY;
+        /**
+         * @brief Ratio of the cell areas, fine over coarse.
+         *
+         */
+        double scale;
+        /**
+         * @brief Residual restricted along y only, nx x (coarse ny).
+         *
+         */
+        std::vector<double> restrictedY;
+        /**
+         * @brief For each coarse point along x, the fine points [rowsBegin, rowsEnd) interpolated from it.
+         *
+         */
+        std::vector<size_t> rowsBegin;
+        std::vector<size_t> rowsEnd;
+    };
+
+    double shift;
+    size_t preSmooth;
+    size_t postSmooth;
+    Smoother smoother;
+    std::vector<Level> levels;
+    BandedMatrix coarsest;
+    /**
+     * @brief Scratch buffers of the solves and of the smoother.
+     *
+     */
+    Workspace workspace;
+
+    /**
+     * @brief One red-black Gauss-Seidel sweep.
+     *
+     * @param level Level.
+     * @param x Values.
+     * @param b Right-hand side.
+     * @param redFirst Update the red points (j + k even) first.
+     */
+    void gaussSeidel(const Level& level, double* x, const double* b, bool redFirst) const;
+
+    /**
+     * @brief Smooth the values of a level.
+     *
+     * @param l Index of the level.
+     * @param x Values.
+     * @param b Right-hand side.
+     * @param sweeps Number of sweeps.
+     * @param pre Smoothing before the coarse correction. The Gauss-Seidel sweeps after it run in the
+     * reverse order, which keeps the cycle symmetric.
+     */
+    void smooth(size_t l, double* x, const double* b, size_t sweeps, bool pre);
+
+    /**
+     * @brief Compute r = b - A x.
+     *
+     * @param level Level.
+     * @param x Values.
+     * @param b Right-hand side.
+     * @param r Residual.
+     */
+    void residual(const Level& level, const double* x, const double* b, double* r) const;
+
+    /**
+     * @brief Restrict the residual of a level to the right-hand side of the next one.
+     *
+     * @param l Index of the fine level.
+     */
+    void restrictResidual(size_t l);
+
+    /**
+     * @brief Add the interpolated correction of the next level to the values of a level.
+     *
+     * @param l Index of the fine level.
+     * @param x Values of the fine level.
+     */
+    void prolongCorrection(size_t l, double* x) const;
+
+    /**
+     * @brief Improve the values of a level with a V-cycle.
+     * The coarse levels use their own x and b, the finest one the given ones.
+     *
+     * @param l Index of the level.
+     * @param x Values.
+     * @param b Right-hand side.
+     */
+    void cycle(size_t l, double* x, const double* b);
+public:
+    /**
+     * @brief Construct a new Multigrid object.
+     *
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     * @param bx Coefficient of the stencil along x.
+     * @param by Coefficient of the stencil along y.
+     * @param shift Coefficient of the identity.
+     * @param preSmooth Number of smoothing sweeps before the coarse correction.
+     * @param postSmooth Number of smoothing sweeps after the coarse correction.
+     * @param smoother Smoother.
+     */
+    Multigrid(size_t nx, size_t ny, double bx, double by, double shift, size_t preSmooth = 2, size_t postSmooth = 2, Smoother smoother = Smoother::GaussSeidel);
+
+    /**
+     * @brief Get the number of levels.
+     *
+     * @return size_t
+     */
+    size_t depth() const { return levels.size(); };
+
+    size_t size() const override { return levels.front().nx * levels.front().ny; };
+
+    void apply(const double* x, double* y) const override;
+
+    /**
+     * @brief Improve x with one V-cycle.
+     *
+     * @param b Right-hand side.
+     * @param x Values.
+     */
+    void vcycle(const double* b, double* x);
+
+    /**
+     * @brief Solve with V-cycles, until ||b - A x|| <= tolerance ||b||.
+     *
+     * @param b Right-hand side.
+     * @param x Initial guess, then solution.
+     * @param tolerance Relative tolerance on the residual.
+     * @param maxCycles Maximum number of V-cycles.
+     * @return size_t Number of V-cycles.
+     * @throws Exn If the solver does not converge.
+     */
+    size_t solve(const std::vector<double>& b, std::vector<double>& x, double tolerance, size_t maxCycles = 100);
+
+    /**
+     * @brief Solve with the conjugate gradient, preconditioned by one V-cycle, until ||b - A x|| <= tolerance ||b||.
+     *
+     * @param b Right-hand side.
+     * @param x Initial guess, then solution.
+     * @param tolerance Relative tolerance on the residual.
+     * @param maxIterations Maximum number of iterations.
+     * @return size_t Number of iterations.
+     * @throws Exn If the solver does not converge.
+     */
+    size_t solveCg(const std::vector<double>& b, std::vector<double>& x, double tolerance, size_t maxIterations = 100);
+};
+
+#endif // MULTIGRID_H
@@ -0,0 +1,182 @@
+/**
+ * @file parallel.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link ParallelPool} class, a persistent team of threads running parallel loops,
+ * and the first-touch allocation of the solver buffers.
+ * @version 0.1
+ * @date 2023-01-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Reference to the body of a loop, called with the bounds [begin, end) of a block.
+ * Unlike a std::function, it never allocates, so that a loop costs no allocation: the body must
+ * outlive the reference, which holds for a lambda passed to {@link parallelFor}.
+ *
+ */
+class BlockFunction
+{
+private:
+    const void *callable;
+    void (*invoke)(const void*, size_t, size_t);
+public:
+    /**
+     * @brief Construct a new Block Function object.
+     *
+     * @tparam F Type of the body.
+     * @param body Body, called as body(begin, end).
+     */
+    template <typename F>
+    BlockFunction(const F& body) : callable(&body), invoke([](const void* f, size_t begin, size_t end) { (*static_cast<const F*>(f))(begin, end); }) {};
+
+    void operator()(size_t begin, size_t end) const { invoke(callable, begin, end); };
+};
+
+/**
+ * @brief Persistent team of threads running loops split in static blocks: the block t of a loop over n items
+ * is [t n / T, (t + 1) n / T), and always runs on the thread t (the caller being the thread 0).
+ * A buffer first touched by a loop therefore lives in the memory of the sockets which later compute on it.
+ *
+ * Only one loop runs on the team at a time: a loop started while the team is busy (from a worker,
+ * or from another thread such as a sweep task) runs on its calling thread.
+ *
+ */
+class ParallelPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    std::mutex busy;
+    const BlockFunction *body;
+    size_t n;
+    size_t blocks;
+    size_t generation;
+    size_t remaining;
+    std::exception_ptr error;
+    bool stop;
+
+    /**
+     * @brief Body of a worker thread.
+     *
+     * @param worker Index of the worker, from 1.
+     */
+    void run(size_t worker);
+public:
+    /**
+     * @brief Construct a new Parallel Pool object.
+     *
+     * @param threads Number of threads, including the calling one, 0 for one per hardware thread.
+     */
+    explicit ParallelPool(size_t threads = 0);
+    ParallelPool(const ParallelPool&) = delete;
+    ParallelPool& operator=(const ParallelPool&) = delete;
+    /**
+     * @brief Destroy the Parallel Pool object.
+     *
+     */
+    ~ParallelPool();
+
+    /**
+     * @brief Get the number of threads, including the calling one.
+     *
+     * @return size_t
+     */
+    size_t size() const { return workers.size() + 1; };
+
+    /**
+     * @brief Run body on the static blocks of [0, n), and wait for them.
+     *
+     * @param n Number of items.
+     * @param body Function called with the bounds [begin, end) of each block.
+     * @param grain Minimum number of items of a block.
+     * @throws The first exception thrown by a block.
+     */
+    void parallelFor(size_t n, BlockFunction body, size_t grain = 1);
+
+    /**
+     * @brief Get the team of the solvers.
+     *
+     * @return ParallelPool&
+     */
+    static ParallelPool& global();
+
+    /**
+     * @brief Replace the team of the solvers. Must not be called while a solver runs.
+     *
+     * @param threads Number of threads, 0 for one per hardware thread.
+     */
+    static void setGlobalThreads(size_t threads);
+};
+
+/**
+ * @brief Run a loop on the team of the solvers (see {@link ParallelPool::parallelFor}).
+ *
+ * @param n Number of items.
+ * @param body Function called with the bounds [begin, end) of each block.
+ * @param grain Minimum number of items of a block.
+ */
+inline void parallelFor(size_t n, BlockFunction body, size_t grain = 1) { ParallelPool::global().parallelFor(n, body, grain); };
+
+/**
+ * @brief Allocator which leaves the values of a resized vector uninitialized, so that the pages of the buffer
+ * are touched first by the loop which fills it, not by the allocating thread.
+ *
+ * @tparam T Type of the values.
+ */
+template <typename T>
+class UninitializedAllocator : public std::allocator<T>
+{
+public:
+    template <typename U>
+    struct rebind
+    {
+        using other = UninitializedAllocator<U>;
+    };
+
+    UninitializedAllocator() = default;
+
+    template <typename U>
+    UninitializedAllocator(const UninitializedAllocator<U>&) noexcept {};
+
+    template <typename U>
+    void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; };
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); };
+};
+
+/**
+ * @brief Buffer of values first touched in parallel (see {@link firstTouch}).
+ *
+ */
+using FirstTouchVector = std::vector<double, UninitializedAllocator<double>>;
+
+/**
+ * @brief Allocate a buffer of rows x rowSize values and fill it by blocks of rows on the team of the solvers,
+ * so that each page is placed on the NUMA node of the thread computing on its rows.
+ *
+ * @param buffer Buffer.
+ * @param rows Number of rows.
+ * @param rowSize Number of values of a row.
+ * @param value Initial value.
+ */
+void firstTouch(FirstTouchVector& buffer, size_t rows, size_t rowSize, double value);
+
+#endif // PARALLEL_H
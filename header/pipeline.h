@@ -0,0 +1,84 @@
+/**
+ * @file pipeline.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link AsyncSink} class, which moves a sink to its own writer thread.
+ * @version 0.1
+ * @date 2023-01-07
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "queue.h"
+#include "sink.h"
+#include "solution.h"
+
+/**
+ * @brief Sink copying each step into a slot of a bounded pool, and handing it to a writer
+ * thread which forwards it to another sink. The solver only waits when all the slots are
+ * waiting to be written, so solving, formatting and writing overlap.
+ *
+ */
+class AsyncSink : public StepSink
+{
+private:
+    /**
+     * @brief Step waiting to be written.
+     *
+     */
+    struct Item
+    {
+        size_t slot;
+        size_t i;
+        double t;
+        bool last;
+    };
+
+    StepSink &sink;
+    size_t depth;
+    size_t nx;
+    size_t ny;
+    Solution slots;
+    SpscQueue<Item> fullSlots;
+    SpscQueue<size_t> freeSlots;
+    std::thread writer;
+    std::exception_ptr error;
+
+    /**
+     * @brief Body of the writer thread.
+     *
+     */
+    void run();
+public:
+    /**
+     * @brief Construct a new Async Sink object.
+     *
+     * @param sink Sink called from the writer thread. It must outlive the stream.
+     * @param depth Number of steps which can wait to be written.
+     */
+    explicit AsyncSink(StepSink& sink, size_t depth = 4);
+    AsyncSink(const AsyncSink&) = delete;
+    AsyncSink& operator=(const AsyncSink&) = delete;
+    /**
+     * @brief Destroy the Async Sink object, waiting for the writer thread.
+     *
+     */
+    ~AsyncSink();
+
+    void begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY) override;
+    void consume(size_t i, double t, ConstStepView step) override;
+    /**
+     * @brief Wait for all the steps to be written, then end the wrapped sink.
+     * @throws The first exception thrown by the wrapped sink in the writer thread.
+     */
+    void end() override;
+};
+
+#endif // PIPELINE_H
@@ -15,6 +15,26 @@
 #include <functional>
 #include <string>
 #include <vector>
+#include "grid.h"
+#include "matrix.h"
+#include "sink.h"
+#include "solution.h"
+#include "stepping.h"
+
+/**
+ * @brief Factorized tridiagonal systems of the ADI scheme of a {@link Plate}, along x and along y
+ * (see {@link triDecomp}). They only depend on the material and on the grid.
+ * 
+ */
+struct AdiOperator
+{
+    std::vector<double> lx;
+    std::vector<double> ux;
+    std::vector<double> upperX;
+    std::vector<double> ly;
+    std::vector<double> uy;
+    std::vector<double> upperY;
+};
 
 /**
  * @brief Class representing a plate.
@@ -30,6 +50,13 @@ private:
     double f;
     std::string material;
 public:
+    /**
+     * @brief Scheme used when the options do not choose one: Crank-Nicolson, solved as the second order
+     * Peaceman-Rachford ADI scheme. The split implicit Euler scheme is first order, and only used on request.
+     * 
+     */
+    static constexpr Scheme defaultScheme = Scheme::CrankNicolson;
+
         /**
      * @brief Construct a new Plate object.
      * 
@@ -74,6 +101,13 @@ public:
      * @return double 
      */
     double getF() const { return f; };
+
+    /**
+     * @brief Get the Material object name.
+     * 
+     * @return const std::string& 
+     */
+    const std::string& getMaterial() const { return material; };
     /**
      * @brief Get the value of the source.
      * 
@@ -83,15 +117,102 @@ public:
      */
     double operator()(double x, double y) const { return this->F(x,y); };
 
+    /**
+     * @brief Assemble the 5-point matrix of the implicit Euler scheme, the matrix the iterative solvers apply
+     * without assembling it (see {@link Multigrid::apply}). Point (j, k) of the grid is the unknown j * ny + k.
+     * 
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     * @param dx Space step along x.
+     * @param dy Space step along y.
+     * @param dt Time step.
+     * @param A Matrix to fill.
+     */
+    void makeOperator(size_t nx, size_t ny, double dx, double dy, double dt, CsrMatrix& A) const;
+
+    /**
+     * @brief Get the time step of the operator used by a scheme: Crank-Nicolson is the Peaceman-Rachford
+     * scheme, and the split implicit Euler scheme solves with the Peaceman-Rachford operator for 2 dt.
+     * 
+     * @param scheme Scheme.
+     * @param dt Time step.
+     * @return double Time step to give to {@link makeAdiOperator}.
+     */
+    static double operatorStep(Scheme scheme, double dt);
+
+    /**
+     * @brief Build and factorize the tridiagonal systems of the ADI scheme.
+     * 
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     * @param dx Space step along x.
+     * @param dy Space step along y.
+     * @param dt Time step.
+     * @param op Operator to fill.
+     */
+    void makeAdiOperator(size_t nx, size_t ny, double dx, double dy, double dt, AdiOperator& op) const;
+
+    /**
+     * @brief Get the thermal diffusivity of the material, lambda / (rho * cp).
+     * 
+     * @return double 
+     */
+    double diffusivity() const;
+
+    /**
+     * @brief Compute the equilibrium temperature, solution of -lambda (u_xx + u_yy) = F with u = u0 outside
+     * of the plate, with a fast Poisson solver in O(nx ny log nx), or with multigrid in O(nx ny).
+     * 
+     * @param grid Grid, along x and y.
+     * @param u Temperature, point (j, k) being stored at j * grid.y.size() + k.
+     * @param options Options of the solve (solver, linear tolerance).
+     * @throws Exn If an iterative solver does not converge.
+     */
+    void steadyState(const Grid& grid, std::vector<double>& u, const SolverOptions& options = SolverOptions()) const;
+
+    /**
+     * @brief Stream the equilibrium temperature as a single step. Its time is tMax, the end of the time axis
+     * of the grid, so that the outputs only hold finite times.
+     * 
+     * @param grid Grid, along time, x and y.
+     * @param sink Sink receiving the step.
+     * @param options Options of the solve (solver, linear tolerance).
+     */
+    void solveSteady(const Grid& grid, StepSink& sink, const SolverOptions& options = SolverOptions()) const;
+
     /**
      * @brief Solve the plate model, using a finite differences method.
      * 
-     * @param time Vector of time.
-     * @param positionX Vector of position along x.
-     * @param positionY Vector of position along y.
-     * @param sol Vector of solution.
+     * @param grid Grid, along time, x and y.
+     * @param sol Solution, resized to grid.time.size() x grid.x.size() x grid.y.size().
+     */
+    void solve(const Grid& grid, Solution& sol) const;
+
+    /**
+     * @brief Solve the plate model, streaming the time steps. Only the current and the
+     * next steps are kept in memory. The operators come from {@link FactorizationCache::global}.
+     * 
+     * @param grid Grid, along time, x and y.
+     * @param sink Sink receiving the steps.
+     * @param options Options of the solve. With a tolerance, the time steps are adaptive (see {@link solveAdaptive}).
+     * With an iterative solver, each step solves the whole 5-point system instead of the ADI splitting.
+     * @return StepStats 
+     * @throws Exn If an iterative solver does not converge.
+     */
+    StepStats solve(const Grid& grid, StepSink& sink, const SolverOptions& options = SolverOptions()) const;
+
+    /**
+     * @brief Solve the plate model with an operator built by {@link makeAdiOperator}.
+     * The operator only depends on the material and on the grid, so it can be shared between plates.
+     * 
+     * @param grid Grid, along time, x and y.
+     * @param op Operator, for the same material, grid sizes, dx, dy and operatorStep(scheme, dt).
+     * @param sink Sink receiving the steps.
+     * @param every Only one step out of every is streamed (the first and the last steps always are).
+     * @param scheme Time integration scheme, implicit.
+     * @throws Exn if op does not match the grid, or if the scheme is explicit.
      */
-    void solve(const std::vector<double>& time, const std::vector<double>& positionX, const std::vector<double>& positionY, std::vector<std::vector<double>>& sol) const;
+    void solve(const Grid& grid, const AdiOperator& op, StepSink& sink, size_t every = 1, Scheme scheme = defaultScheme) const;
 };
 
 
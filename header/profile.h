@@ -0,0 +1,331 @@
+/**
+ * @file profile.h
+ * @author Thomas Roiseux
+ * @brief Provides the instrumentation of a run: timers of the phases, counters, and hardware counters read
+ * with perf_event_open (--profile), and a timeline of the phases of each thread (--trace). Everything is
+ * disabled by default, and then costs a relaxed atomic load.
+ * @version 0.1
+ * @date 2023-01-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Events counted during a run.
+ *
+ */
+enum class Counter
+{
+    /**
+     * @brief Time steps taken by the solvers.
+     *
+     */
+    Steps,
+    /**
+     * @brief Linear systems solved (a batch of systems sharing a matrix counts once).
+     *
+     */
+    Solves,
+    /**
+     * @brief Bytes written by the text and binary outputs.
+     *
+     */
+    BytesWritten,
+    /**
+     * @brief Calls to the global operator new.
+     *
+     */
+    Allocations
+};
+
+/**
+ * @brief Number of {@link Counter} values.
+ *
+ */
+constexpr size_t counterCount = 4;
+
+/**
+ * @brief Get the name of a counter.
+ *
+ * @param counter Counter.
+ * @return const char*
+ */
+const char* counterName(Counter counter);
+
+/**
+ * @brief Collects the timings of the phases and the counters of a run, once enabled.
+ *
+ */
+class Profiler
+{
+public:
+    /**
+     * @brief Accumulated time of a phase.
+     *
+     */
+    struct Phase
+    {
+        size_t calls = 0;
+        double seconds = 0;
+    };
+
+    /**
+     * @brief Hardware counter.
+     *
+     */
+    struct HardwareCounter
+    {
+        const char* name;
+        int fd;
+    };
+private:
+    /**
+     * @brief Phases of a thread. Only its thread adds to it, so adding a call takes no lock.
+     *
+     */
+    using PhaseTable = std::map<std::string, Phase, std::less<>>;
+
+    // Constant-initialized, so that they can be used before main (operator new).
+    static inline std::atomic<bool> active{false};
+    static inline std::atomic<uint64_t> counters[counterCount] = {};
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<PhaseTable>> tables;
+    std::vector<HardwareCounter> hardware;
+    std::chrono::steady_clock::time_point start;
+
+    Profiler() = default;
+
+    /**
+     * @brief Get the phases of the calling thread, registered on its first phase.
+     *
+     * @return PhaseTable&
+     */
+    PhaseTable& table();
+public:
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    /**
+     * @brief Destroy the Profiler object, closing the hardware counters.
+     *
+     */
+    ~Profiler();
+
+    /**
+     * @brief Get the profiler of the process.
+     *
+     * @return Profiler&
+     */
+    static Profiler& global();
+
+    /**
+     * @brief Check if the profiler is enabled.
+     *
+     * @return true The phases and the counters are recorded.
+     * @return false Nothing is recorded.
+     */
+    static bool enabled() { return active.load(std::memory_order_relaxed); };
+
+    /**
+     * @brief Add to a counter, if the profiler is enabled.
+     *
+     * @param counter Counter.
+     * @param n Amount.
+     */
+    static void count(Counter counter, uint64_t n = 1)
+    {
+        if (enabled())
+        {
+            counters[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief Get the value of a counter.
+     *
+     * @param counter Counter.
+     * @return uint64_t
+     */
+    static uint64_t value(Counter counter) { return counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed); };
+
+    /**
+     * @brief Start recording, and open the hardware counters of the calling thread and of the threads
+     * it starts afterwards (they are counted once they exit). The hardware counters are skipped if
+     * perf_event_open is not permitted.
+     *
+     */
+    void enable();
+
+    /**
+     * @brief Add a call to a phase of the calling thread.
+     *
+     * @param name Phase.
+     * @param seconds Duration of the call.
+     */
+    void addPhase(std::string_view name, double seconds);
+
+    /**
+     * @brief Write the report: the time of each phase (including the phases nested in it), summed over the
+     * threads, the counters and the hardware counters. The threads must be done with their phases.
+     *
+     * @param out Stream.
+     * @param json If the report is JSON instead of a table.
+     */
+    void report(std::ostream& out, bool json);
+};
+
+/**
+ * @brief Records the phases of every thread, and writes them as a Chrome trace (JSON trace event format),
+ * which chrome://tracing and Perfetto display as a timeline.
+ *
+ */
+class TraceRecorder
+{
+public:
+    /**
+     * @brief Phase of a thread, in microseconds since the trace was enabled.
+     *
+     */
+    struct Event
+    {
+        const char* name;
+        double begin;
+        double duration;
+    };
+private:
+    /**
+     * @brief Events of a thread. Only its thread appends to it, so recording takes no lock.
+     *
+     */
+    struct ThreadBuffer
+    {
+        size_t thread;
+        std::vector<Event> events;
+    };
+
+    static inline std::atomic<bool> active{false};
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::ofstream file;
+    std::string filename;
+    std::chrono::steady_clock::time_point start;
+
+    TraceRecorder() = default;
+
+    /**
+     * @brief Get the buffer of the calling thread, registered on its first event.
+     *
+     * @return ThreadBuffer&
+     */
+    ThreadBuffer& buffer();
+public:
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * @brief Get the trace recorder of the process.
+     *
+     * @return TraceRecorder&
+     */
+    static TraceRecorder& global();
+
+    /**
+     * @brief Check if the phases are recorded.
+     *
+     * @return true The phases are recorded.
+     * @return false Nothing is recorded.
+     */
+    static bool enabled() { return active.load(std::memory_order_relaxed); };
+
+    /**
+     * @brief Start recording.
+     *
+     * @param name File written by {@link write}, opened now so that a bad path fails before the run.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    void enable(const std::string& name);
+
+    /**
+     * @brief Record a phase of the calling thread.
+     *
+     * @param name Name of the phase, a string literal.
+     * @param begin Start of the phase.
+     * @param end End of the phase.
+     */
+    void record(const char* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end);
+
+    /**
+     * @brief Stop recording and write the trace. The recorded threads must be done with their phases.
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void write();
+};
+
+/**
+ * @brief Timer of a phase, from its construction to its destruction, added to the profile and to the trace.
+ * Does nothing if both are disabled when it is constructed.
+ *
+ */
+class ScopedPhase
+{
+private:
+    const char* name;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+public:
+    /**
+     * @brief Construct a new Scoped Phase object, starting the timer.
+     *
+     * @param name Name of the phase, a string literal.
+     */
+    explicit ScopedPhase(const char* name) : name(name), active(Profiler::enabled() || TraceRecorder::enabled())
+    {
+        if (active)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    };
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+    /**
+     * @brief Destroy the Scoped Phase object, adding its duration to the phase and recording it.
+     *
+     */
+    ~ScopedPhase()
+    {
+        if (active)
+        {
+            const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if (Profiler::enabled())
+            {
+                Profiler::global().addPhase(name, std::chrono::duration<double>(end - start).count());
+            }
+            if (TraceRecorder::enabled())
+            {
+                TraceRecorder::global().record(name, start, end);
+            }
+        }
+    };
+};
+
+#endif // PROFILE_H
@@ -0,0 +1,121 @@
+/**
+ * @file queue.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link SpscQueue} class, a bounded lock-free single producer single consumer queue.
+ * @version 0.1
+ * @date 2023-01-07
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free queue, for exactly one producer thread and one consumer thread.
+ * The blocking operations sleep on the indices (std::atomic::wait) instead of spinning.
+ *
+ * @tparam T Type of the items.
+ */
+template <typename T>
+class SpscQueue
+{
+private:
+    std::vector<T> items;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+public:
+    /**
+     * @brief Construct a new Spsc Queue object.
+     *
+     * @param capacity Minimum number of items the queue can hold.
+     */
+    explicit SpscQueue(size_t capacity) : head(0), tail(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        items.resize(size);
+        mask = size - 1;
+    };
+
+    /**
+     * @brief Add an item, if the queue is not full. Producer only.
+     *
+     * @param item Item.
+     * @return true The item was added.
+     * @return false The queue is full.
+     */
+    bool tryPush(const T& item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == items.size())
+        {
+            return false;
+        }
+        items[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    };
+
+    /**
+     * @brief Add an item, waiting for the queue not to be full. Producer only.
+     *
+     * @param item Item.
+     */
+    void push(const T& item)
+    {
+        while (!tryPush(item))
+        {
+            const size_t h = head.load(std::memory_order_acquire);
+            if (tail.load(std::memory_order_relaxed) - h == items.size())
+            {
+                head.wait(h, std::memory_order_acquire);
+            }
+        }
+    };
+
+    /**
+     * @brief Remove the oldest item, if the queue is not empty. Consumer only.
+     *
+     * @param item Removed item.
+     * @return true An item was removed.
+     * @return false The queue is empty.
+     */
+    bool tryPop(T& item)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == h)
+        {
+            return false;
+        }
+        item = items[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        head.notify_one();
+        return true;
+    };
+
+    /**
+     * @brief Remove the oldest item, waiting for the queue not to be empty. Consumer only.
+     *
+     * @param item Removed item.
+     */
+    void pop(T& item)
+    {
+        while (!tryPop(item))
+        {
+            tail.wait(head.load(std::memory_order_relaxed), std::memory_order_acquire);
+        }
+    };
+};
+
+#endif // QUEUE_H
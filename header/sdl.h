@@ -16,6 +16,7 @@
 #include <vector>
 #include "bar.h"
 #include "plate.h"
+#include "solution.h"
 
 
 /**
@@ -45,7 +46,7 @@ public:
      * @param position Position values.
      * @param sol Solution.
      */
-    static void SdlBarRunWindow(const Bar& bar, const std::vector<double>& time, const std::vector<double>& position, std::vector<std::vector<double>>& sol);
+    static void SdlBarRunWindow(const Bar& bar, const std::vector<double>& time, const std::vector<double>& position, const Solution& sol);
     /**
      * @brief Run the SDL window.
      * @throws Exn if the window cannot be created.
@@ -55,7 +56,7 @@ public:
      * @param positionY Position values along y.
      * @param sol Solution.
      */
-    static void SdlBarRunWindow(const Plate& plate, const std::vector<double>& time, const std::vector<double>& positionX, const std::vector<double>& positionY, std::vector<std::vector<std::vector<double>>>& sol);
+    static void SdlBarRunWindow(const Plate& plate, const std::vector<double>& time, const std::vector<double>& positionX, const std::vector<double>& positionY, const Solution& sol);
 };
 
 #endif // SDL_H
\ No newline at end of file
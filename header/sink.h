@@ -0,0 +1,159 @@
+/**
+ * @file sink.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link StepSink} interface, through which solvers stream their time steps.
+ * @version 0.1
+ * @date 2023-01-04
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "solution.h"
+#include "textwriter.h"
+
+/**
+ * @brief Get the number of steps streamed when only every k-th step is kept.
+ * The first and the last steps are always kept.
+ *
+ * @param nt Number of time steps.
+ * @param every Keep one step out of every.
+ * @return size_t
+ */
+size_t streamedSteps(size_t nt, size_t every);
+
+/**
+ * @brief Check if a step is streamed when only every k-th step is kept.
+ *
+ * @param i Time step.
+ * @param nt Number of time steps.
+ * @param every Keep one step out of every.
+ * @return true The step is streamed.
+ * @return false The step is skipped.
+ */
+inline bool isStreamed(size_t i, size_t nt, size_t every) { return i % every == 0 || i == nt - 1; };
+
+/**
+ * @brief Receives the time steps computed by a solver, one after the other.
+ * The solver only keeps the steps it needs, so sinks must copy what they want to keep.
+ *
+ */
+class StepSink
+{
+public:
+    /**
+     * @brief Destroy the Step Sink object.
+     *
+     */
+    virtual ~StepSink();
+
+    /**
+     * @brief Called once, before the first step.
+     *
+     * @param steps Number of steps that will be streamed.
+     * @param positionX Position along x.
+     * @param positionY Position along y, empty for a bar.
+     */
+    virtual void begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY);
+
+    /**
+     * @brief Called for each streamed step.
+     *
+     * @param i Index of the step in the time vector.
+     * @param t Time.
+     * @param step Values. They are only valid during the call.
+     */
+    virtual void consume(size_t i, double t, ConstStepView step) = 0;
+
+    /**
+     * @brief Called once, after the last step.
+     *
+     */
+    virtual void end();
+};
+
+/**
+ * @brief Sink keeping the streamed steps in a {@link Solution}.
+ *
+ */
+class SolutionSink : public StepSink
+{
+private:
+    Solution &sol;
+    std::vector<double> time;
+public:
+    /**
+     * @brief Construct a new Solution Sink object.
+     *
+     * @param sol Solution to fill. It is resized when the stream begins.
+     */
+    explicit SolutionSink(Solution& sol);
+
+    /**
+     * @brief Get the time of each kept step.
+     *
+     * @return const std::vector<double>&
+     */
+    const std::vector<double>& times() const { return time; };
+
+    void begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY) override;
+    void consume(size_t i, double t, ConstStepView step) override;
+};
+
+/**
+ * @brief Sink writing the steps as text, one line per step, through a {@link TextWriter}.
+ * The first lines hold the positions, then each line starts with the time.
+ *
+ */
+class CsvSink : public StepSink
+{
+private:
+    TextWriter writer;
+    std::string separator;
+    std::string prefix;
+public:
+    /**
+     * @brief Construct a new Csv Sink object.
+     *
+     * @param out Stream to write to.
+     * @param separator Separator written after each value.
+     * @param prefix Written at the start of the position line of a bar.
+     * @param precision Number of significant digits, 0 for the shortest representation which reads back to the same double.
+     * @param threads Number of threads formatting long rows.
+     */
+    CsvSink(std::ostream& out, const std::string& separator, const std::string& prefix = "", int precision = 0, size_t threads = 1);
+
+    void begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY) override;
+    void consume(size_t i, double t, ConstStepView step) override;
+    void end() override;
+};
+
+/**
+ * @brief Sink forwarding the steps to several sinks.
+ *
+ */
+class TeeSink : public StepSink
+{
+private:
+    std::vector<StepSink *> sinks;
+public:
+    /**
+     * @brief Add a sink. It must outlive the stream.
+     *
+     * @param sink Sink.
+     */
+    void add(StepSink& sink) { sinks.push_back(&sink); };
+
+    void begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY) override;
+    void consume(size_t i, double t, ConstStepView step) override;
+    void end() override;
+};
+
+#endif // SINK_H
@@ -0,0 +1,192 @@
+/**
+ * @file solution.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link Solution} container, shared by the solvers, the exporters and the GUI.
+ * @version 0.1
+ * @date 2023-01-03
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+
+/**
+ * @brief View on the nx x ny values of one time step. Point (j, k) is stored at j * ny + k.
+ *
+ * @tparam T double or const double.
+ */
+template <typename T>
+class BasicStepView
+{
+private:
+    T *ptr;
+    size_t nx;
+    size_t ny;
+public:
+    /**
+     * @brief Construct a new Step View object.
+     *
+     * @param ptr First value of the step.
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     */
+    BasicStepView(T *ptr, size_t nx, size_t ny) : ptr(ptr), nx(nx), ny(ny) {};
+
+    /**
+     * @brief Get the value at a point.
+     *
+     * @param j Index along x.
+     * @param k Index along y.
+     * @return T&
+     */
+    T& operator()(size_t j, size_t k = 0) const { return ptr[j * ny + k]; };
+
+    /**
+     * @brief Get the value at a flat index.
+     *
+     * @param i Index.
+     * @return T&
+     */
+    T& operator[](size_t i) const { return ptr[i]; };
+
+    /**
+     * @brief Get the number of points along x.
+     *
+     * @return size_t
+     */
+    size_t sizeX() const { return nx; };
+
+    /**
+     * @brief Get the number of points along y.
+     *
+     * @return size_t
+     */
+    size_t sizeY() const { return ny; };
+
+    /**
+     * @brief Get the number of values.
+     *
+     * @return size_t
+     */
+    size_t size() const { return nx * ny; };
+
+    T* data() const { return ptr; };
+    T* begin() const { return ptr; };
+    T* end() const { return ptr + nx * ny; };
+};
+
+/**
+ * @brief Mutable view on a time step.
+ *
+ */
+using StepView = BasicStepView<double>;
+
+/**
+ * @brief Read-only view on a time step.
+ *
+ */
+using ConstStepView = BasicStepView<const double>;
+
+/**
+ * @brief Solution of a model: nt time steps of nx x ny values, stored in a single
+ * contiguous and cache line aligned buffer. Value (i, j, k) is stored at (i * nx + j) * ny + k.
+ * A bar is a solution with ny = 1.
+ *
+ */
+class Solution
+{
+private:
+    /**
+     * @brief Deleter of the aligned buffer.
+     *
+     */
+    struct Free
+    {
+        void operator()(double *p) const { std::free(p); };
+    };
+
+    size_t nt;
+    size_t nx;
+    size_t ny;
+    std::unique_ptr<double[], Free> values;
+public:
+    /**
+     * @brief Alignment of the buffer, in bytes.
+     *
+     */
+    static constexpr size_t alignment = 64;
+
+    /**
+     * @brief Construct a new Solution object.
+     *
+     * @param nt Number of time steps.
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     * @throws std::bad_alloc if the buffer cannot be allocated.
+     */
+    explicit Solution(size_t nt = 0, size_t nx = 0, size_t ny = 1);
+
+    Solution(Solution&&) = default;
+    Solution& operator=(Solution&&) = default;
+
+    /**
+     * @brief Change the dimensions. Values are not preserved.
+     *
+     * @param nt Number of time steps.
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     * @throws std::bad_alloc if the buffer cannot be allocated.
+     */
+    void resize(size_t nt, size_t nx, size_t ny = 1);
+
+    /**
+     * @brief Get the number of time steps.
+     *
+     * @return size_t
+     */
+    size_t steps() const { return nt; };
+
+    /**
+     * @brief Get the number of points along x.
+     *
+     * @return size_t
+     */
+    size_t sizeX() const { return nx; };
+
+    /**
+     * @brief Get the number of points along y.
+     *
+     * @return size_t
+     */
+    size_t sizeY() const { return ny; };
+
+    /**
+     * @brief Get the number of values of a time step.
+     *
+     * @return size_t
+     */
+    size_t stepSize() const { return nx * ny; };
+
+    double& operator()(size_t i, size_t j, size_t k = 0) { return values[(i * nx + j) * ny + k]; };
+    double operator()(size_t i, size_t j, size_t k = 0) const { return values[(i * nx + j) * ny + k]; };
+
+    /**
+     * @brief Get a view on a time step.
+     *
+     * @param i Time step.
+     * @return StepView
+     */
+    StepView operator[](size_t i) { return StepView(values.get() + i * nx * ny, nx, ny); };
+    ConstStepView operator[](size_t i) const { return ConstStepView(values.get() + i * nx * ny, nx, ny); };
+
+    double* data() { return values.get(); };
+    const double* data() const { return values.get(); };
+};
+
+#endif // SOLUTION_H
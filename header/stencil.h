@@ -0,0 +1,157 @@
+/**
+ * @file stencil.h
+ * @author Thomas Roiseux
+ * @brief Provides the matrix-free stencil kernels of the bar and the plate, and the {@link LinearOperator} interface.
+ * @version 0.1
+ * @date 2023-01-14
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <cstddef>
+
+/**
+ * @brief Apply the constant 3-point stencil y_i = a u_i + b (u_(i-1) + u_(i+1)),
+ * the values outside of [0, n) being left and right.
+ * The kernel is vectorized with the widest instruction set of the processor (see {@link stencilIsa}). Every
+ * point is computed with fused multiply-adds, so that all the instruction sets give the same results.
+ *
+ * @param u Values.
+ * @param y Result, must not overlap u.
+ * @param n Number of values.
+ * @param a Coefficient of the center.
+ * @param b Coefficient of the neighbours.
+ * @param left Value before the first point.
+ * @param right Value after the last point.
+ */
+void stencil3(const double* u, double* y, size_t n, double a, double b, double left, double right);
+
+/**
+ * @brief Apply the constant 5-point stencil y = a u + bx (west + east) + by (south + north) on the rows
+ * [jBegin, jEnd) of a nx x ny grid, point (j, k) being stored at j * ny + k. The values outside
+ * of the grid are ghost.
+ * The kernel is vectorized with the widest instruction set of the processor (see {@link stencilIsa}), and gives
+ * the same results with all of them (see {@link stencil3}).
+ *
+ * @param u Values.
+ * @param y Result, must not overlap u.
+ * @param nx Number of points along x.
+ * @param ny Number of points along y.
+ * @param a Coefficient of the center.
+ * @param bx Coefficient of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param ghost Value outside of the grid.
+ * @param jBegin First row.
+ * @param jEnd Row after the last one.
+ */
+void stencil5(const double* u, double* y, size_t nx, size_t ny, double a, double bx, double by, double ghost, size_t jBegin, size_t jEnd);
+
+/**
+ * @brief Apply the constant 5-point stencil on the whole grid (see {@link stencil5}).
+ *
+ * @param u Values.
+ * @param y Result, must not overlap u.
+ * @param nx Number of points along x.
+ * @param ny Number of points along y.
+ * @param a Coefficient of the center.
+ * @param bx Coefficient of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param ghost Value outside of the grid.
+ */
+inline void stencil5(const double* u, double* y, size_t nx, size_t ny, double a, double bx, double by, double ghost) { stencil5(u, y, nx, ny, a, bx, by, ghost, 0, nx); };
+
+/**
+ * @brief Get the instruction set of the stencil kernels, chosen once at run time: "avx512", "avx2" or "generic".
+ *
+ * @return const char*
+ */
+const char* stencilIsa();
+
+/**
+ * @brief Linear operator known through its product, for the iterative solvers.
+ *
+ */
+class LinearOperator
+{
+public:
+    /**
+     * @brief Destroy the Linear Operator object.
+     *
+     */
+    virtual ~LinearOperator() = default;
+
+    /**
+     * @brief Get the number of unknowns.
+     *
+     * @return size_t
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Compute y = A x.
+     *
+     * @param x Values.
+     * @param y Result, must not overlap x.
+     */
+    virtual void apply(const double* x, double* y) const = 0;
+};
+
+/**
+ * @brief Operator a I + b L of a line of n points, L = [1 -2 1] being 0 outside of the line.
+ *
+ */
+class Stencil3Operator : public LinearOperator
+{
+private:
+    size_t n;
+    double a;
+    double b;
+public:
+    /**
+     * @brief Construct a new Stencil 3 Operator object.
+     *
+     * @param n Number of points.
+     * @param a Coefficient of the identity.
+     * @param b Coefficient of L.
+     */
+    Stencil3Operator(size_t n, double a, double b) : n(n), a(a), b(b) {};
+
+    size_t size() const override { return n; };
+
+    void apply(const double* x, double* y) const override { stencil3(x, y, n, a - 2 * b, b, 0, 0); };
+};
+
+/**
+ * @brief Operator a I + bx Lx + by Ly of a nx x ny grid, Lx and Ly being [1 -2 1] along x and y, 0 outside of the grid.
+ *
+ */
+class Stencil5Operator : public LinearOperator
+{
+private:
+    size_t nx;
+    size_t ny;
+    double a;
+    double bx;
+    double by;
+public:
+    /**
+     * @brief Construct a new Stencil 5 Operator object.
+     *
+     * @param nx Number of points along x.
+     * @param ny Number of points along y.
+     * @param a Coefficient of the identity.
+     * @param bx Coefficient of Lx.
+     * @param by Coefficient of Ly.
+     */
+    Stencil5Operator(size_t nx, size_t ny, double a, double bx, double by) : nx(nx), ny(ny), a(a), bx(bx), by(by) {};
+
+    size_t size() const override { return nx * ny; };
+
+    void apply(const double* x, double* y) const override { stencil5(x, y, nx, ny, a - 2 * bx - 2 * by, bx, by, 0); };
+};
+
+#endif // STENCIL_H
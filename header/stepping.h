@@ -0,0 +1,214 @@
+/**
+ * @file stepping.h
+ * @author Thomas Roiseux
+ * @brief Provides the options of the solvers, and the fixed and adaptive time stepping drivers.
+ * @version 0.1
+ * @date 2023-01-11
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef STEPPING_H
+#define STEPPING_H
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include "grid.h"
+#include "multigrid.h"
+#include "sink.h"
+
+/**
+ * @brief Time integration scheme.
+ *
+ */
+enum class Scheme
+{
+    /**
+     * @brief Implicit (backward) Euler, first order.
+     *
+     */
+    Euler,
+    /**
+     * @brief Crank-Nicolson, second order.
+     *
+     */
+    CrankNicolson,
+    /**
+     * @brief Explicit (forward) Euler in time and centered in space (FTCS), first order. Each time step is split
+     * in sub-steps short enough to be stable (see {@link explicitSubSteps}), and no system is solved.
+     *
+     */
+    Explicit
+};
+
+/**
+ * @brief Get the order of convergence in time of a scheme.
+ *
+ * @param scheme Scheme.
+ * @return unsigned
+ */
+inline unsigned order(Scheme scheme) { return scheme == Scheme::CrankNicolson ? 2 : 1; };
+
+/**
+ * @brief Parse the name of a scheme: "euler", "cn" or "ftcs".
+ *
+ * @param name Name.
+ * @return Scheme
+ * @throws Exn If the name is unknown.
+ */
+Scheme parseScheme(const std::string& name);
+
+/**
+ * @brief Get the number of sub-steps of an explicit time step, so that each one is below the stability
+ * limit (the CFL condition of the heat equation, dt <= 1 / (2 sum(alpha / dx^2))).
+ *
+ * @param dt Time step.
+ * @param stableStep Longest stable sub-step.
+ * @return size_t
+ */
+size_t explicitSubSteps(double dt, double stableStep);
+
+/**
+ * @brief Solver of the linear systems of the plate.
+ *
+ */
+enum class LinearSolver
+{
+    /**
+     * @brief Direct solvers: the ADI splitting for the time steps, the fast Poisson solver for the steady state.
+     *
+     */
+    Direct,
+    /**
+     * @brief Multigrid V-cycles on the whole 5-point system (see {@link Multigrid}).
+     *
+     */
+    Multigrid,
+    /**
+     * @brief Conjugate gradient on the whole 5-point system, preconditioned by a multigrid V-cycle.
+     *
+     */
+    ConjugateGradient
+};
+
+/**
+ * @brief Parse the name of a linear solver: "direct", "mg" or "pcg".
+ *
+ * @param name Name.
+ * @return LinearSolver
+ * @throws Exn If the name is unknown.
+ */
+LinearSolver parseLinearSolver(const std::string& name);
+
+/**
+ * @brief Options of a solve.
+ *
+ */
+struct SolverOptions
+{
+    /**
+     * @brief Only one step out of every is streamed (the first and the last steps always are).
+     *
+     */
+    size_t every = 1;
+    /**
+     * @brief Time integration scheme, none for the default scheme of the model ({@link Bar::defaultScheme},
+     * {@link Plate::defaultScheme}).
+     *
+     */
+    std::optional<Scheme> scheme;
+    /**
+     * @brief Tolerance on the error of each time step, relative to the temperature.
+     * 0 for fixed time steps, the ones of the grid.
+     *
+     */
+    double tolerance = 0;
+    /**
+     * @brief Solver of the linear systems. The bar is always solved directly.
+     *
+     */
+    LinearSolver solver = LinearSolver::Direct;
+    /**
+     * @brief Tolerance of the iterative linear solvers, on the residual relative to the right-hand side.
+     *
+     */
+    double linearTolerance = 1e-10;
+    /**
+     * @brief Smoother of the multigrid cycles.
+     *
+     */
+    Smoother smoother = Smoother::GaussSeidel;
+    /**
+     * @brief Number of explicit sub-steps advanced per wavefront of the tiled stencil engine
+     * (see {@link tiledStencil5}), 0 to choose it from the grid, 1 for one sweep per sub-step.
+     *
+     */
+    size_t tileDepth = 0;
+};
+
+/**
+ * @brief Statistics of a solve.
+ *
+ */
+struct StepStats
+{
+    /**
+     * @brief Number of time steps taken.
+     *
+     */
+    size_t steps = 0;
+    /**
+     * @brief Number of time steps rejected by the error control.
+     *
+     */
+    size_t rejected = 0;
+    /**
+     * @brief Number of iterations of the iterative linear solver, over all the steps.
+     *
+     */
+    size_t iterations = 0;
+};
+
+/**
+ * @brief Advance the values by one time step.
+ * The function may be called with the same vector as input and output.
+ *
+ */
+using StepFunction = std::function<void(double dt, const std::vector<double>& cur, std::vector<double>& next)>;
+
+/**
+ * @brief Integrate with the time steps of the grid.
+ *
+ * @param grid Grid.
+ * @param u Initial values, then values at the end.
+ * @param step Step function.
+ * @param sink Sink receiving the steps.
+ * @param every Only one step out of every is streamed (the first and the last steps always are).
+ * @return StepStats
+ */
+StepStats solveFixed(const Grid& grid, std::vector<double>& u, const StepFunction& step, StepSink& sink, size_t every);
+
+/**
+ * @brief Integrate with adaptive time steps, controlled by step doubling: each step is taken once with dt
+ * and twice with dt / 2, and the difference estimates the error (Richardson). The step doubles when the
+ * error is well below the tolerance, and is halved and retried when it is above.
+ * Steps are always the grid time step times a power of 2, so that only a few operators are factorized.
+ * The steps streamed to the sink are the grid time steps, interpolated linearly between the computed steps.
+ *
+ * @param grid Grid. Its time step is the initial step.
+ * @param tolerance Tolerance on the error of a step, relative to max(1, |u|).
+ * @param order Order of the scheme of the step function.
+ * @param u Initial values, then values at the end.
+ * @param step Step function.
+ * @param sink Sink receiving the steps.
+ * @param every Only one step out of every is streamed (the first and the last steps always are).
+ * @return StepStats
+ * @throws Exn If the tolerance is not positive.
+ */
+StepStats solveAdaptive(const Grid& grid, double tolerance, unsigned order, std::vector<double>& u, const StepFunction& step, StepSink& sink, size_t every);
+
+#endif // STEPPING_H
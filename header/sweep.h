@@ -0,0 +1,61 @@
+/**
+ * @file sweep.h
+ * @author Thomas Roiseux
+ * @brief Provides the sweep mode, which solves many scenarios concurrently.
+ * @version 0.1
+ * @date 2023-01-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <string>
+#include <vector>
+#include "computation.h"
+
+/**
+ * @brief Scenario of a sweep.
+ *
+ */
+struct Scenario
+{
+    bool plate;
+    std::string material;
+    double u0;
+    double tMax;
+    double f;
+    double L;
+    /**
+     * @brief Output file: CSV if its name ends with ".csv", binary otherwise.
+     *
+     */
+    std::string output;
+};
+
+/**
+ * @brief Read a job file. Each line describes a scenario:
+ * <bar|plate> <material> <u0> <tMax> <f> <L> [output].
+ * Empty lines and lines starting with '#' are ignored. The default output of the
+ * scenario on line n is "scenario-n.bin".
+ *
+ * @param filename Job file.
+ * @return std::vector<Scenario>
+ * @throws std::runtime_error if the file cannot be read or a line is invalid.
+ */
+std::vector<Scenario> readJobFile(const std::string& filename);
+
+/**
+ * @brief Solve scenarios concurrently on a work-stealing thread pool.
+ * Scenarios with the same model, material and grid share a single factorized operator.
+ * A failing scenario is reported and does not stop the others.
+ *
+ * @param scenarios Scenarios.
+ * @param options Options of the run (jobs, every, precision).
+ * @return size_t Number of failed scenarios.
+ */
+size_t runSweep(const std::vector<Scenario>& scenarios, const RunOptions& options);
+
+#endif // SWEEP_H
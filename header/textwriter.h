@@ -0,0 +1,127 @@
+/**
+ * @file textwriter.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link TextWriter} class, a buffered text output engine for numbers.
+ * @version 0.1
+ * @date 2023-01-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "parallel.h"
+
+/**
+ * @brief Writes text to a stream through a large buffer, formatting doubles with std::to_chars
+ * (locale independent). Long rows can be formatted in parallel, chunk by chunk, on a team of threads kept
+ * for the life of the writer.
+ *
+ */
+class TextWriter
+{
+private:
+    std::ostream &out;
+    int precision;
+    size_t threads;
+    std::vector<char> buffer;
+    size_t used;
+    std::vector<std::vector<char>> chunks;
+    /**
+     * @brief Team formatting the chunks of long rows, null with a single thread.
+     *
+     */
+    std::unique_ptr<ParallelPool> pool;
+
+    /**
+     * @brief Format values at the end of a buffer.
+     *
+     * @param values Values.
+     * @param n Number of values.
+     * @param separator Written after each value.
+     * @param chunk Buffer to append to.
+     */
+    void format(const double* values, size_t n, const std::string& separator, std::vector<char>& chunk) const;
+
+    /**
+     * @brief Write characters to the stream, counting them (see {@link Counter::BytesWritten}).
+     *
+     * @param data Characters.
+     * @param size Number of characters.
+     */
+    void emit(const char* data, size_t size);
+public:
+    /**
+     * @brief Largest number of characters written for a double.
+     *
+     */
+    static constexpr size_t maxDoubleSize = 64;
+
+    /**
+     * @brief Minimum number of values of a row for it to be formatted in parallel.
+     *
+     */
+    static constexpr size_t parallelThreshold = 1 << 14;
+
+    /**
+     * @brief Construct a new Text Writer object.
+     *
+     * @param out Stream to write to.
+     * @param precision Number of significant digits, 0 for the shortest representation which reads back to the same double.
+     * @param threads Number of threads formatting long rows, including the calling one.
+     * @param bufferSize Size of the write buffer, in bytes.
+     */
+    explicit TextWriter(std::ostream& out, int precision = 0, size_t threads = 1, size_t bufferSize = 4 << 20);
+    TextWriter(const TextWriter&) = delete;
+    TextWriter& operator=(const TextWriter&) = delete;
+    /**
+     * @brief Destroy the Text Writer object, flushing the buffer.
+     *
+     */
+    ~TextWriter();
+
+    /**
+     * @brief Write a double.
+     *
+     * @param value Value.
+     */
+    void write(double value);
+
+    /**
+     * @brief Write a string.
+     *
+     * @param s String.
+     */
+    void write(const std::string& s);
+
+    /**
+     * @brief Write a character.
+     *
+     * @param c Character.
+     */
+    void write(char c);
+
+    /**
+     * @brief Write values, each one followed by a separator.
+     *
+     * @param values Values.
+     * @param n Number of values.
+     * @param separator Separator.
+     */
+    void writeRow(const double* values, size_t n, const std::string& separator);
+
+    /**
+     * @brief Write the buffer to the stream, and flush the stream.
+     *
+     */
+    void flush();
+};
+
+#endif // TEXTWRITER_H
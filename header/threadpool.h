@@ -0,0 +1,114 @@
+/**
+ * @file threadpool.h
+ * @author Thomas Roiseux
+ * @brief Provides the {@link ThreadPool} class, a work-stealing thread pool.
+ * @version 0.1
+ * @date 2023-01-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Pool of worker threads. Each worker has its own task queue: it runs its newest task first,
+ * and steals the oldest task of another worker when its queue is empty.
+ * Tasks submitted from a worker go to its own queue.
+ *
+ */
+class ThreadPool
+{
+private:
+    /**
+     * @brief Task queue of a worker.
+     *
+     */
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable idle;
+    size_t pending;
+    /**
+     * @brief First exception thrown by a task since the last wait.
+     *
+     */
+    std::exception_ptr error;
+    std::atomic<size_t> queued;
+    std::atomic<size_t> next;
+    bool stop;
+
+    /**
+     * @brief Take a task, from the queue of a worker first.
+     *
+     * @param worker Worker.
+     * @param task Task taken.
+     * @return true A task was taken.
+     * @return false All the queues are empty.
+     */
+    bool take(size_t worker, std::function<void()>& task);
+
+    /**
+     * @brief Body of a worker thread.
+     *
+     * @param worker Worker.
+     */
+    void run(size_t worker);
+public:
+    /**
+     * @brief Construct a new Thread Pool object.
+     *
+     * @param threads Number of workers, 0 for one per hardware thread.
+     */
+    explicit ThreadPool(size_t threads = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    /**
+     * @brief Destroy the Thread Pool object, once all the tasks are done.
+     *
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Get the number of workers.
+     *
+     * @return size_t
+     */
+    size_t size() const { return workers.size(); };
+
+    /**
+     * @brief Submit a task. If it throws, the exception is rethrown by the next wait.
+     *
+     * @param task Task.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Wait for all the tasks, including the ones they submit, to be done.
+     * Must not be called from a worker.
+     *
+     * @throws The first exception thrown by a task since the last wait, once all the tasks are done.
+     */
+    void wait();
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,72 @@
+/**
+ * @file tiling.h
+ * @author Thomas Roiseux
+ * @brief Provides the temporally tiled 5-point stencil engine of the plate.
+ * @version 0.1
+ * @date 2023-01-14
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef TILING_H
+#define TILING_H
+
+#include <cstddef>
+#include "workspace.h"
+
+/**
+ * @brief Choose the number of time steps advanced per wavefront, so that the rows it touches stay in cache.
+ *
+ * @param ny Number of points of a row.
+ * @param steps Number of time steps to advance.
+ * @return size_t
+ */
+size_t tileDepth(size_t ny, size_t steps);
+
+/**
+ * @brief Apply steps times u <- a u + bx (west + east) + by (south + north) + sourceScale source on a
+ * nx x ny grid, point (j, k) being stored at j * ny + k and the values outside of the grid being ghost.
+ *
+ * The steps are advanced depth at a time by a skewed wavefront along x: at each position j of the wave,
+ * step 1 updates row j, step 2 row j - 1, ..., step depth row j - depth + 1. The rows a wave touches are few
+ * enough to stay in cache, so each row is read from memory once every depth steps instead of once per step.
+ * Two buffers are enough, the even steps being written in u and the odd steps in work.
+ * With several threads, the grid is cut in one slab of rows per thread, each running its own wave.
+ *
+ * @param u Values, then result.
+ * @param work Work buffer of nx * ny values.
+ * @param nx Number of points along x.
+ * @param ny Number of points along y.
+ * @param a Coefficient of the center.
+ * @param bx Coefficient of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param ghost Value outside of the grid.
+ * @param source Source added at each step, or nullptr.
+ * @param sourceScale Coefficient of the source.
+ * @param steps Number of steps.
+ * @param workspace Workspace the windows of the slabs are taken from.
+ * @param depth Number of steps per wavefront, 0 to choose it with {@link tileDepth}, 1 for one sweep per step.
+ */
+void tiledStencil5(double* u, double* work, size_t nx, size_t ny, double a, double bx, double by, double ghost, const double* source, double sourceScale, size_t steps, Workspace& workspace, size_t depth = 0);
+
+/**
+ * @brief Weighted Jacobi sweeps on (shift I - bx Lx - by Ly) x = b, x being 0 outside of the grid:
+ * x <- (1 - omega) x + omega (b + bx (west + east) + by (south + north)) / (shift + 2 bx + 2 by).
+ * A sweep is the 5-point stencil with a source, so the sweeps run on {@link tiledStencil5}.
+ *
+ * @param x Values, then result.
+ * @param b Right-hand side.
+ * @param work Work buffer of nx * ny values.
+ * @param nx Number of points along x.
+ * @param ny Number of points along y.
+ * @param shift Coefficient of the identity.
+ * @param bx Coefficient of the stencil along x.
+ * @param by Coefficient of the stencil along y.
+ * @param omega Weight.
+ * @param sweeps Number of sweeps.
+ * @param workspace Workspace of the stencil engine.
+ */
+void jacobiSweeps(double* x, const double* b, double* work, size_t nx, size_t ny, double shift, double bx, double by, double omega, size_t sweeps, Workspace& workspace);
+
+#endif // TILING_H
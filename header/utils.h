@@ -13,6 +13,7 @@
 #define UTILS_H
 
 #include <vector>
+#include "matrix.h"
 
 /**
  * @brief Adds v2 to v1.
@@ -29,8 +30,9 @@ void addVector(std::vector<double>& v1, const std::vector<double>& v2);
  * @param A Matrix.
  * @param L Lower triangular matrix.
  * @param U Upper triangular matrix.
+ * @throws Exn if A is not square or if a pivot is zero.
  */
-void luDecomp(const std::vector<std::vector<double>>& A, std::vector<std::vector<double>>& L, std::vector<std::vector<double>>& U);
+void luDecomp(const DenseMatrix& A, DenseMatrix& L, DenseMatrix& U);
 
 /**
  * @brief Solves a linear system.
@@ -38,8 +40,48 @@ void luDecomp(const std::vector<std::vector<double>>& A, std::vector<std::vector
  * @param L Lower triangular matrix.
  * @param U Upper triangular matrix.
  * @param b Right-hand side.
+ * @param x Solution, may be b. Solved in place, without temporary.
+ */
+void luSolve(const DenseMatrix& L, const DenseMatrix& U, const std::vector<double>& b, std::vector<double>& x);
+
+/**
+ * @brief Computes the LU decomposition of a tridiagonal matrix (Thomas algorithm).
+ * Runs in O(n) and only has to be done once for a given matrix.
+ * 
+ * @param lower Sub-diagonal, lower[i] = A[i][i - 1] (lower[0] is not used).
+ * @param diag Diagonal, diag[i] = A[i][i].
+ * @param upper Super-diagonal, upper[i] = A[i][i + 1] (upper[n - 1] is not used).
+ * @param l Multipliers of the lower triangular matrix.
+ * @param u Diagonal of the upper triangular matrix.
+ * @throws Exn if the diagonals have different sizes or if a pivot is zero.
+ */
+void triDecomp(const std::vector<double>& lower, const std::vector<double>& diag, const std::vector<double>& upper, std::vector<double>& l, std::vector<double>& u);
+
+/**
+ * @brief Solves a tridiagonal linear system in O(n), using the decomposition computed by {@link triDecomp}.
+ * 
+ * @param l Multipliers of the lower triangular matrix.
+ * @param u Diagonal of the upper triangular matrix.
+ * @param upper Super-diagonal of the matrix.
+ * @param b Right-hand side.
  * @param x Solution.
+ * @throws Exn if the decomposition and the vector sizes do not match.
+ */
+void triSolve(const std::vector<double>& l, const std::vector<double>& u, const std::vector<double>& upper, const std::vector<double>& b, std::vector<double>& x);
+
+/**
+ * @brief Solves several tridiagonal systems sharing the same matrix, using the decomposition computed by {@link triDecomp}.
+ * Element i of system c is stored at index i * stride + c, so that count contiguous systems are solved together.
+ * x may be equal to b.
+ * 
+ * @param l Multipliers of the lower triangular matrix.
+ * @param u Diagonal of the upper triangular matrix.
+ * @param upper Super-diagonal of the matrix.
+ * @param b Right-hand sides.
+ * @param x Solutions.
+ * @param count Number of systems.
+ * @param stride Distance between two consecutive elements of a system.
  */
-void luSolve(const std::vector<std::vector<double>>& L, const std::vector<std::vector<double>>& U, const std::vector<double>& b, std::vector<double>& x);
+void triSolve(const std::vector<double>& l, const std::vector<double>& u, const std::vector<double>& upper, const double* b, double* x, size_t count = 1, size_t stride = 1);
 
 #endif // UTILS_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * @file workspace.h
+ * @author Thomas Roiseux
+ * @brief Provides the arena the solvers draw their scratch buffers from, so that their time loops do not allocate.
+ * @version 0.1
+ * @date 2023-01-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Stack of scratch buffers of a solve. Buffers are taken inside a {@link Workspace::Frame}, and given
+ * back together when it closes. The first steps of a solve grow the arena; when the outermost frame closes,
+ * its blocks are merged into one as large as the most the frames ever took, so that the next steps, which
+ * take the same buffers, do not allocate anymore.
+ *
+ * A workspace belongs to one thread: the blocks of a parallel loop use buffers taken before the loop.
+ *
+ */
+class Workspace
+{
+private:
+    /**
+     * @brief Block of memory, used from its start.
+     *
+     */
+    struct Block
+    {
+        std::unique_ptr<double[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    /**
+     * @brief Block buffers are taken from.
+     *
+     */
+    size_t current;
+    /**
+     * @brief Values taken from the current block.
+     *
+     */
+    size_t used;
+    /**
+     * @brief Values taken from all the blocks, and the most ever taken.
+     *
+     */
+    size_t taken;
+    size_t peak;
+    size_t frames;
+
+    /**
+     * @brief Take a buffer.
+     *
+     * @param n Number of values.
+     * @return double* Buffer, valid until its frame closes.
+     */
+    double* take(size_t n);
+
+    /**
+     * @brief Merge the blocks into one, when no buffer is taken.
+     *
+     */
+    void merge();
+public:
+    /**
+     * @brief Buffers taken together, and given back when the frame is destroyed. Frames are nested.
+     *
+     */
+    class Frame
+    {
+    private:
+        Workspace &workspace;
+        size_t current;
+        size_t used;
+        size_t taken;
+    public:
+        /**
+         * @brief Construct a new Frame object.
+         *
+         * @param workspace Workspace to take the buffers from.
+         */
+        explicit Frame(Workspace& workspace);
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+        /**
+         * @brief Destroy the Frame object, giving its buffers back.
+         *
+         */
+        ~Frame();
+
+        /**
+         * @brief Take a buffer. Its values are not initialized.
+         *
+         * @param n Number of values.
+         * @return double* Buffer of n values aligned on a cache line, valid until the frame is destroyed.
+         */
+        double* take(size_t n) { return workspace.take(n); };
+    };
+
+    /**
+     * @brief Construct a new empty Workspace object.
+     *
+     */
+    Workspace();
+    Workspace(Workspace&&) = default;
+    Workspace& operator=(Workspace&&) = default;
+
+    /**
+     * @brief Get the most values taken at once.
+     *
+     * @return size_t
+     */
+    size_t capacity() const { return peak; };
+};
+
+#endif // WORKSPACE_H
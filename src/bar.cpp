@@ -10,11 +10,15 @@
  */
 
 #include "../header/bar.h"
+#include "../header/cache.h"
 #include "../header/exn.h"
+#include "../header/heatsolver.h"
 #include "../header/materials.h"
+#include "../header/profile.h"
 #include "../header/utils.h"
 
-#include <thread>
+#include <algorithm>
+#include <array>
 #include <map>
 #include <iostream>
 
@@ -45,66 +49,276 @@ Bar::~Bar()
 {
 }
 
-void Bar::solve(const std::vector<double> &time, const std::vector<double> &position, std::vector<std::vector<double>> &sol) const
+/**
+ * @brief Get the factors of the tridiagonal operator of the bar, read in its band storage.
+ * 
+ * @param A Factorized operator, with one sub-diagonal and one super-diagonal.
+ * @return TridiagonalView<double>
+ */
+TridiagonalView<double> tridiagonal(const BandedMatrix &A)
 {
+    return {A.band(), A.band() + 1, A.band() + 2, 3, A.rows()};
+}
+
+double Bar::operatorStep(Scheme scheme, double dt)
+{
+    return scheme == Scheme::CrankNicolson ? dt / 2 : dt;
+}
+
+void Bar::makeOperator(size_t n, double dx, double dt, BandedMatrix &A) const
+{
+    ScopedPhase phase("assembly");
     const Material &mat = Material::materials[material];
-    sol.resize(time.size());
-    for (size_t i = 0; i < time.size(); i++)
+    const double a = - (2 * mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity() * dx * dx) + 1 / dt);
+    const double b = mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity() * dx * dx);
+
+    A = BandedMatrix(n, 1, 1);
+    for (size_t i = 0; i < n; i++)
     {
-        sol[i].resize(position.size());
-        sol[0][i] = u0;
-        sol[i][position.size() - 1] = u0;
+        A.set(i, i, a);
+        if (i > 0)
+        {
+            A.set(i, i - 1, b);
+        }
+        if (i < n - 1)
+        {
+            A.set(i, i + 1, b);
+        }
     }
-    const double dx = position[1] - position[0];
-    
-    const double dt = time[1] - time[0];
-    const double a = - (2 * mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity() * dx * dx) + 1 / dt);
+}
+
+double Bar::diffusivity() const
+{
+    const Material &mat = Material::materials[material];
+    return mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity());
+}
+
+void Bar::makeRightHandSide(const Grid &grid, std::vector<double> &B, std::vector<double> &C) const
+{
+    const Material &mat = Material::materials[material];
+    const size_t n = grid.x.size();
+    const double dx = grid.x.step();
     const double b = mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity() * dx * dx);
 
-    std::vector<std::vector<double>> A(position.size(), std::vector<double>(position.size(), 0.0));
+    C.assign(n, 0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        C[i] = -1 / (mat.getDensity() * mat.getSpecificHeatCapacity()) * this->F(grid.x[i]);
+    }
 
-    std::thread aThread([this, &a,&b, &A](){
-        for (size_t i = 0; i < A.size(); i++)
+    B.assign(n, 0.0);
+    B[n - 1] = - b * u0;
+    B[0] = -b * u0;
+}
+
+void Bar::steadyState(const Grid &grid, std::vector<double> &u) const
+{
+    ScopedPhase phase("steady state");
+    // At equilibrium, L u = B + C: the operator without its 1 / dt term, a single tridiagonal solve.
+    const size_t n = grid.x.size();
+    const double b = diffusivity() / (grid.x.step() * grid.x.step());
+    std::vector<double> B, C, l, d;
+    makeRightHandSide(grid, B, C);
+    const std::vector<double> offDiagonal(n, b);
+    triDecomp(offDiagonal, std::vector<double>(n, -2 * b), offDiagonal, l, d);
+    addVector(B, C);
+    triSolve(l, d, offDiagonal, B, u);
+}
+
+void Bar::solveSteady(const Grid &grid, StepSink &sink, const SolverOptions &) const
+{
+    std::vector<double> u;
+    steadyState(grid, u);
+    sink.begin(1, grid.x.points(), {});
+    sink.consume(0, grid.time.getLength(), ConstStepView(u.data(), u.size(), 1));
+    sink.end();
+}
+
+void Bar::solve(const Grid &grid, Solution &sol) const
+{
+    SolutionSink sink(sol);
+    solve(grid, sink);
+}
+
+/**
+ * @brief Solve the bar with a scheme, the operators of the implicit schemes being taken from the
+ * factorization cache. The scheme is a template parameter, so that the steps are dispatched once per solve.
+ * 
+ * @tparam S Scheme.
+ * @param bar Bar.
+ * @param grid Grid.
+ * @param sink Sink of the steps.
+ * @param options Options of the solver.
+ * @return StepStats
+ */
+template <Scheme S>
+StepStats solveScheme(const Bar &bar, const Grid &grid, StepSink &sink, const SolverOptions &options)
+{
+    StepStats stats;
+    const size_t n = grid.x.size();
+    const double b = bar.diffusivity() / (grid.x.step() * grid.x.step());
+    std::vector<double> B, C;
+    bar.makeRightHandSide(grid, B, C);
+    HeatSolver<1, S, double> solver({HeatAxis<double>{{nullptr, nullptr, nullptr, 0, n}, b}}, bar.getU0(), B.data(), C.data());
+    std::shared_ptr<const BandedMatrix> A;
+    // The cache hands out the same operator for the same time step, so the solver is only rebound when dt changes.
+    auto useOperator = [&](double dt)
+    {
+        if constexpr (S != Scheme::Explicit)
         {
-            A[i][i] = a;
-            if (i > 0)
+            std::shared_ptr<const BandedMatrix> op = FactorizationCache::global().barOperator(bar, n, grid.x.step(), Bar::operatorStep(S, dt));
+            if (op != A)
             {
-                A[i][i - 1] = b;
-            }
-            if (i < A.size() - 1)
-            {
-                A[i][i + 1] = b;
+                A = op;
+                solver.setAxes({HeatAxis<double>{tridiagonal(*A), b}});
             }
         }
-    });
-    std::vector<double> C(position.size(), 0.0);
-    std::thread cThread([this, &mat, &C, &position](){
-        for (size_t i = 0; i < C.size(); i++)
+    };
+    if (options.tolerance == 0)
+    {
+        useOperator(grid.time.step());
+        solver.run(grid, sink, options.every);
+        stats.steps = grid.time.size() - 1;
+        return stats;
+    }
+
+    std::vector<double> u(n, bar.getU0()), work(n);
+    const StepFunction step = [&](double dt, const std::vector<double> &cur, std::vector<double> &next)
+    {
+        useOperator(dt);
+        next.resize(n);
+        solver.step(dt, cur.data(), work.data(), next.data());
+    };
+    return solveAdaptive(grid, options.tolerance, order(S), u, step, sink, options.every);
+}
+
+StepStats Bar::solve(const Grid &grid, StepSink &sink, const SolverOptions &options) const
+{
+    const Scheme scheme = options.scheme.value_or(defaultScheme);
+    if (scheme == Scheme::CrankNicolson)
+    {
+        return solveScheme<Scheme::CrankNicolson>(*this, grid, sink, options);
+    }
+    else if (scheme == Scheme::Explicit)
+    {
+        return solveScheme<Scheme::Explicit>(*this, grid, sink, options);
+    }
+    return solveScheme<Scheme::Euler>(*this, grid, sink, options);
+}
+
+void Bar::solve(const Grid &grid, const BandedMatrix &A, StepSink &sink, size_t every, Scheme scheme) const
+{
+    const size_t n = grid.x.size();
+    const double b = diffusivity() / (grid.x.step() * grid.x.step());
+
+    if (scheme == Scheme::Explicit)
+    {
+        throw Exn("The explicit scheme does not use an operator.");
+    }
+    if (!A.isFactorized() || A.rows() != n || A.lowerBandwidth() != 1 || A.upperBandwidth() != 1)
+    {
+        throw Exn("Operator is not factorized for this grid.");
+    }
+
+    std::vector<double> B, C;
+    makeRightHandSide(grid, B, C);
+    const std::array<HeatAxis<double>, 1> axes = {HeatAxis<double>{tridiagonal(A), b}};
+    if (scheme == Scheme::CrankNicolson)
+    {
+        HeatSolver<1, Scheme::CrankNicolson, double>(axes, u0, B.data(), C.data()).run(grid, sink, every);
+    }
+    else
+    {
+        HeatSolver<1, Scheme::Euler, double>(axes, u0, B.data(), C.data()).run(grid, sink, every);
+    }
+}
+
+/**
+ * @brief Check that bars can be solved as a batch.
+ * 
+ * @param bars Bars.
+ * @param sinks Sink of each bar.
+ * @throws Exn if the bars do not share their material and length, or if there is not one sink per bar.
+ */
+void checkBatch(const std::vector<Bar> &bars, const std::vector<StepSink *> &sinks)
+{
+    if (sinks.size() != bars.size())
+    {
+        throw Exn("A batch needs one sink per bar.");
+    }
+    for (const Bar &bar : bars)
+    {
+        if (bar.getMaterial() != bars[0].getMaterial() || bar.getL() != bars[0].getL())
         {
-            C[i] =  -1 / (mat.getDensity() * mat.getSpecificHeatCapacity()) * this->F(position[i]);
+            throw Exn("The bars of a batch must share their material and length.");
         }
-    });
-    
+    }
+}
 
-    std::vector<double> B(position.size(), 0.0);
-    B[position.size() - 1] = - b * u0;
-    B[0] = -b * u0;
+StepStats Bar::solveBatch(const std::vector<Bar> &bars, const Grid &grid, const std::vector<StepSink *> &sinks, const SolverOptions &options)
+{
+    checkBatch(bars, sinks);
+    StepStats stats;
+    const Scheme scheme = options.scheme.value_or(defaultScheme);
+    if (bars.empty())
+    {
+        return stats;
+    }
+    if (options.tolerance == 0 && scheme != Scheme::Explicit)
+    {
+        std::shared_ptr<const BandedMatrix> A = FactorizationCache::global().barOperator(bars[0], grid.x.size(), grid.x.step(), operatorStep(scheme, grid.time.step()));
+        solveBatch(bars, grid, *A, sinks, options.every, scheme);
+        stats.steps = grid.time.size() - 1;
+        return stats;
+    }
+    for (size_t c = 0; c < bars.size(); c++)
+    {
+        const StepStats barStats = bars[c].solve(grid, *sinks[c], options);
+        stats.steps = std::max(stats.steps, barStats.steps);
+        stats.rejected += barStats.rejected;
+    }
+    return stats;
+}
 
-    aThread.join();
-    cThread.join();
+void Bar::solveBatch(const std::vector<Bar> &bars, const Grid &grid, const BandedMatrix &A, const std::vector<StepSink *> &sinks, size_t every, Scheme scheme)
+{
+    checkBatch(bars, sinks);
+    if (bars.empty())
+    {
+        return;
+    }
+    const size_t n = grid.x.size();
+    const size_t K = bars.size();
+    const double b = bars[0].diffusivity() / (grid.x.step() * grid.x.step());
+
+    if (scheme == Scheme::Explicit)
+    {
+        throw Exn("The explicit scheme does not use an operator.");
+    }
+    if (!A.isFactorized() || A.rows() != n || A.lowerBandwidth() != 1 || A.upperBandwidth() != 1)
+    {
+        throw Exn("Operator is not factorized for this grid.");
+    }
 
-    std::vector<std::vector<double>> l(time.size(),std::vector<double>(time.size(), 0.0)), u(time.size(),std::vector<double>(time.size(), 0.0));
-    luDecomp(A, l, u);
-    for (size_t i = 0; i < time.size() - 1; i++)
+    // Boundary and source terms and initial values of every bar, one lane per bar.
+    std::vector<double> boundary(n * K), source(n * K), initial(n * K), B, C;
+    for (size_t c = 0; c < K; c++)
     {
-        std::vector<double> values(sol[i]);
-        std::vector<double> result(sol[i].size());
-        for (size_t i = 0; i < values.size(); i++)
+        bars[c].makeRightHandSide(grid, B, C);
+        for (size_t j = 0; j < n; j++)
         {
-            values[i] *= -1 / dt;
-            values[i] += B[i] + C[i];
+            boundary[j * K + c] = B[j];
+            source[j * K + c] = C[j];
+            initial[j * K + c] = bars[c].getU0();
         }
-        luSolve(l, u, values, result);
-        sol[i + 1] = result;
     }
-}
\ No newline at end of file
+    const std::array<HeatAxis<double>, 1> axes = {HeatAxis<double>{tridiagonal(A), b}};
+    if (scheme == Scheme::CrankNicolson)
+    {
+        HeatSolver<1, Scheme::CrankNicolson, double>(axes, bars[0].getU0(), boundary.data(), source.data(), K).run(grid, sinks, every, initial.data());
+    }
+    else
+    {
+        HeatSolver<1, Scheme::Euler, double>(axes, bars[0].getU0(), boundary.data(), source.data(), K).run(grid, sinks, every, initial.data());
+    }
+}
@@ -0,0 +1,317 @@
+/**
+ * @file binary.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link binary.h}.
+ * @version 0.1
+ * @date 2023-01-05
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/binary.h"
+#include "../header/exn.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Convert a value from or to little-endian.
+ *
+ * @tparam T Arithmetic type.
+ * @param value Value.
+ * @return T
+ */
+template <typename T>
+T little(T value)
+{
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        return value;
+    }
+    else
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+}
+
+/**
+ * @brief Write a whole buffer at a given offset.
+ *
+ * @param fd File descriptor.
+ * @param data Buffer.
+ * @param size Size of the buffer.
+ * @param offset Offset in the file.
+ * @param filename Name of the file, for error messages.
+ * @throws std::runtime_error if the buffer cannot be written.
+ */
+void writeAt(int fd, const void *data, size_t size, uint64_t offset, const std::string &filename)
+{
+    const char *p = static_cast<const char *>(data);
+    while (size > 0)
+    {
+        const ssize_t written = pwrite(fd, p, size, offset);
+        if (written <= 0)
+        {
+            throw std::runtime_error("Unable to write file " + filename);
+        }
+        p += written;
+        size -= written;
+        offset += written;
+    }
+    Profiler::count(Counter::BytesWritten, p - static_cast<const char *>(data));
+}
+
+/**
+ * @brief Multiply two sizes read from a file.
+ *
+ * @param a First size.
+ * @param b Second size.
+ * @param product Set to a * b.
+ * @return false if the product overflows 64 bits.
+ */
+bool multiply(uint64_t a, uint64_t b, uint64_t& product)
+{
+    if (a != 0 && b > std::numeric_limits<uint64_t>::max() / a)
+    {
+        return false;
+    }
+    product = a * b;
+    return true;
+}
+
+/**
+ * @brief Check that an array described in a header lies in the file.
+ *
+ * @param offset Offset of the array.
+ * @param count Number of elements.
+ * @param size Size of an element.
+ * @param length Length of the file.
+ * @return true if offset + count * size fits in the file, without overflow.
+ */
+bool fitsIn(uint64_t offset, uint64_t count, uint64_t size, uint64_t length)
+{
+    uint64_t bytes;
+    return multiply(count, size, bytes) && offset <= length && bytes <= length - offset;
+}
+
+BinaryHeader makeBinaryHeader(const BinaryInfo& info, size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY, bool singlePrecision)
+{
+    BinaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "HEATEQ", 6);
+    header.version = 1;
+    header.valueSize = singlePrecision ? sizeof(float) : sizeof(double);
+    header.steps = steps;
+    header.sizeX = positionX.size();
+    header.sizeY = positionY.empty() ? 1 : positionY.size();
+    header.timesOffset = sizeof(BinaryHeader);
+    header.valuesOffset = (header.timesOffset + steps * sizeof(double) + Solution::alignment - 1) / Solution::alignment * Solution::alignment;
+    header.dt = info.dt;
+    header.dx = positionX.size() > 1 ? positionX[1] - positionX[0] : 0.0;
+    header.dy = positionY.size() > 1 ? positionY[1] - positionY[0] : 0.0;
+    header.u0 = info.u0;
+    header.f = info.f;
+    header.L = info.L;
+    header.tMax = info.tMax;
+    std::strncpy(header.material, info.material.c_str(), sizeof(header.material) - 1);
+    return header;
+}
+
+BinaryHeader littleEndian(const BinaryHeader& header)
+{
+    BinaryHeader out = header;
+    out.version = little(out.version);
+    out.valueSize = little(out.valueSize);
+    out.steps = little(out.steps);
+    out.sizeX = little(out.sizeX);
+    out.sizeY = little(out.sizeY);
+    out.timesOffset = little(out.timesOffset);
+    out.valuesOffset = little(out.valuesOffset);
+    out.dt = little(out.dt);
+    out.dx = little(out.dx);
+    out.dy = little(out.dy);
+    out.u0 = little(out.u0);
+    out.f = little(out.f);
+    out.L = little(out.L);
+    out.tMax = little(out.tMax);
+    return out;
+}
+
+BinaryWriter::BinaryWriter(const std::string& filename, const BinaryInfo& info, bool singlePrecision) : filename(filename), info(info), singlePrecision(singlePrecision), fd(-1), header(), used(0), offset(0)
+{
+}
+
+BinaryWriter::~BinaryWriter()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+void BinaryWriter::flush()
+{
+    writeAt(fd, buffer.data(), used, offset, filename);
+    offset += used;
+    used = 0;
+}
+
+void BinaryWriter::begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY)
+{
+    fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to open file " + filename);
+    }
+    header = makeBinaryHeader(info, steps, positionX, positionY, singlePrecision);
+
+    time.clear();
+    time.reserve(steps);
+    buffer.resize(bufferSize);
+    used = 0;
+    offset = header.valuesOffset;
+}
+
+void BinaryWriter::consume(size_t, double t, ConstStepView step)
+{
+    ScopedPhase phase("output/binary");
+    // The values start right after the announced times: one more step would overwrite them.
+    if (time.size() == header.steps)
+    {
+        throw std::runtime_error("More steps than announced for file " + filename);
+    }
+    time.push_back(little(t));
+    size_t done = 0;
+    while (done < step.size())
+    {
+        if (used == buffer.size())
+        {
+            flush();
+        }
+        const size_t count = std::min(step.size() - done, (buffer.size() - used) / header.valueSize);
+        if (singlePrecision)
+        {
+            float *out = reinterpret_cast<float *>(buffer.data() + used);
+            for (size_t i = 0; i < count; i++)
+            {
+                out[i] = little(static_cast<float>(step[done + i]));
+            }
+        }
+        else if constexpr (std::endian::native == std::endian::little)
+        {
+            std::memcpy(buffer.data() + used, step.data() + done, count * sizeof(double));
+        }
+        else
+        {
+            double *out = reinterpret_cast<double *>(buffer.data() + used);
+            for (size_t i = 0; i < count; i++)
+            {
+                out[i] = little(step[done + i]);
+            }
+        }
+        used += count * header.valueSize;
+        done += count;
+    }
+}
+
+void BinaryWriter::end()
+{
+    ScopedPhase phase("output/binary");
+    flush();
+    buffer.clear();
+    buffer.shrink_to_fit();
+    header.steps = time.size();
+    writeAt(fd, time.data(), time.size() * sizeof(double), header.timesOffset, filename);
+
+    const BinaryHeader out = littleEndian(header);
+    writeAt(fd, &out, sizeof(out), 0, filename);
+
+    close(fd);
+    fd = -1;
+}
+
+BinaryResult::BinaryResult(const std::string& filename) : map(MAP_FAILED), length(0), hdr(nullptr)
+{
+    if constexpr (std::endian::native != std::endian::little)
+    {
+        throw std::runtime_error("Result files can only be mapped on little-endian hosts.");
+    }
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to open file " + filename);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BinaryHeader))
+    {
+        close(fd);
+        throw std::runtime_error("Invalid result file " + filename);
+    }
+    length = st.st_size;
+    map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map file " + filename);
+    }
+    hdr = static_cast<const BinaryHeader *>(map);
+    uint64_t stepSize, valueCount;
+    if (std::memcmp(hdr->magic, "HEATEQ\0\0", 8) != 0 || hdr->version != 1 || (hdr->valueSize != 4 && hdr->valueSize != 8) || !multiply(hdr->sizeX, hdr->sizeY, stepSize) || !multiply(hdr->steps, stepSize, valueCount) || !fitsIn(hdr->timesOffset, hdr->steps, sizeof(double), length) || !fitsIn(hdr->valuesOffset, valueCount, hdr->valueSize, length))
+    {
+        munmap(map, length);
+        throw std::runtime_error("Invalid result file " + filename);
+    }
+}
+
+BinaryResult::~BinaryResult()
+{
+    munmap(map, length);
+}
+
+double BinaryResult::time(size_t i) const
+{
+    return reinterpret_cast<const double *>(static_cast<const char *>(map) + hdr->timesOffset)[i];
+}
+
+double BinaryResult::value(size_t i, size_t j, size_t k) const
+{
+    const size_t index = (i * hdr->sizeX + j) * hdr->sizeY + k;
+    const char *values = static_cast<const char *>(map) + hdr->valuesOffset;
+    if (hdr->valueSize == sizeof(float))
+    {
+        return reinterpret_cast<const float *>(values)[index];
+    }
+    return reinterpret_cast<const double *>(values)[index];
+}
+
+ConstStepView BinaryResult::step(size_t i) const
+{
+    if (hdr->valueSize != sizeof(double))
+    {
+        throw Exn("Result file does not hold float64 values.");
+    }
+    const double *values = reinterpret_cast<const double *>(static_cast<const char *>(map) + hdr->valuesOffset);
+    return ConstStepView(values + i * hdr->sizeX * hdr->sizeY, hdr->sizeX, hdr->sizeY);
+}
+
+const float* BinaryResult::floatValues() const
+{
+    if (hdr->valueSize != sizeof(float))
+    {
+        throw Exn("Result file does not hold float32 values.");
+    }
+    return reinterpret_cast<const float *>(static_cast<const char *>(map) + hdr->valuesOffset);
+}
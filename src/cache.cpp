@@ -0,0 +1,400 @@
+/**
+ * @file cache.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link cache.h}.
+ * @version 0.1
+ * @date 2023-01-09
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/cache.h"
+#include "../header/materials.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+
+/**
+ * @brief Magic number of the operator files.
+ *
+ */
+static const char operatorMagic[8] = {'H', 'E', 'A', 'T', 'O', 'P', '1', '\0'};
+
+bool OperatorKey::operator<(const OperatorKey& other) const
+{
+    return std::tie(plate, lambda, rho, cp, nx, ny, dx, dy, dt) < std::tie(other.plate, other.lambda, other.rho, other.cp, other.nx, other.ny, other.dx, other.dy, other.dt);
+}
+
+bool OperatorKey::operator==(const OperatorKey& other) const
+{
+    return std::tie(plate, lambda, rho, cp, nx, ny, dx, dy, dt) == std::tie(other.plate, other.lambda, other.rho, other.cp, other.nx, other.ny, other.dx, other.dy, other.dt);
+}
+
+/**
+ * @brief Serialize a key, in native byte order.
+ *
+ * @param key Key.
+ * @return std::string
+ */
+std::string keyBytes(const OperatorKey& key)
+{
+    const uint64_t sizes[3] = {key.plate ? 1u : 0u, key.nx, key.ny};
+    const double values[6] = {key.lambda, key.rho, key.cp, key.dx, key.dy, key.dt};
+    std::string bytes(sizeof(sizes) + sizeof(values), '\0');
+    std::memcpy(bytes.data(), sizes, sizeof(sizes));
+    std::memcpy(bytes.data() + sizeof(sizes), values, sizeof(values));
+    return bytes;
+}
+
+/**
+ * @brief Write a vector: its size, then its values.
+ *
+ * @param out Binary stream.
+ * @param v Vector.
+ */
+void writeVector(std::ostream& out, const std::vector<double>& v)
+{
+    const uint64_t size = v.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(double));
+}
+
+/**
+ * @brief Read a vector written by {@link writeVector}.
+ *
+ * @param in Binary stream.
+ * @param v Vector.
+ * @param size Expected size.
+ * @return true The vector was read.
+ * @return false The stream does not hold a vector of this size.
+ */
+bool readVector(std::istream& in, std::vector<double>& v, size_t size)
+{
+    uint64_t actual;
+    if (!in.read(reinterpret_cast<char *>(&actual), sizeof(actual)) || actual != size)
+    {
+        return false;
+    }
+    v.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(v.data()), size * sizeof(double)));
+}
+
+void writeOperator(std::ostream& out, const BandedMatrix& A)
+{
+    A.write(out);
+}
+
+bool readOperator(std::istream& in, const OperatorKey& key, BandedMatrix& A)
+{
+    A.read(in);
+    // The operator of a bar is tridiagonal (see Bar::makeOperator), and the solvers rely on it.
+    return A.isFactorized() && A.rows() == key.nx && A.lowerBandwidth() == 1 && A.upperBandwidth() == 1;
+}
+
+void writeOperator(std::ostream& out, const AdiOperator& op)
+{
+    for (const std::vector<double> *v : {&op.lx, &op.ux, &op.upperX, &op.ly, &op.uy, &op.upperY})
+    {
+        writeVector(out, *v);
+    }
+}
+
+/**
+ * @brief Get the size of an operator.
+ *
+ * @param A Operator of a bar.
+ * @return size_t Bytes.
+ */
+size_t operatorBytes(const BandedMatrix& A)
+{
+    return A.memory();
+}
+
+/**
+ * @brief Get the size of an operator.
+ *
+ * @param op Operator of a plate.
+ * @return size_t Bytes.
+ */
+size_t operatorBytes(const AdiOperator& op)
+{
+    return (op.lx.size() + op.ux.size() + op.upperX.size() + op.ly.size() + op.uy.size() + op.upperY.size()) * sizeof(double);
+}
+
+/**
+ * @brief Find the least recently used operator which is built.
+ *
+ * @tparam Entries Map of the entries of a type of operator.
+ * @param entries Entries.
+ * @return Iterator on the entry, end if no operator is built.
+ */
+template <typename Entries>
+typename Entries::iterator leastRecentlyUsed(Entries& entries)
+{
+    auto oldest = entries.end();
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->second.bytes > 0 && (oldest == entries.end() || it->second.lastUse < oldest->second.lastUse))
+        {
+            oldest = it;
+        }
+    }
+    return oldest;
+}
+
+bool readOperator(std::istream& in, const OperatorKey& key, AdiOperator& op)
+{
+    return readVector(in, op.lx, key.nx) && readVector(in, op.ux, key.nx) && readVector(in, op.upperX, key.nx)
+        && readVector(in, op.ly, key.ny) && readVector(in, op.uy, key.ny) && readVector(in, op.upperY, key.ny);
+}
+
+/**
+ * @brief Load an operator persisted by {@link save}.
+ *
+ * @tparam T Type of the operator.
+ * @param file File.
+ * @param key Key of the operator.
+ * @param op Operator.
+ * @return true The operator was loaded.
+ * @return false The file does not exist, or holds another operator.
+ */
+template <typename T>
+bool load(const std::string& file, const OperatorKey& key, T& op)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open())
+    {
+        return false;
+    }
+    const std::string expected = keyBytes(key);
+    std::string header(sizeof(operatorMagic) + expected.size(), '\0');
+    if (!in.read(header.data(), header.size()) || header.compare(0, sizeof(operatorMagic), operatorMagic, sizeof(operatorMagic)) != 0 || header.compare(sizeof(operatorMagic), std::string::npos, expected) != 0)
+    {
+        return false;
+    }
+    try
+    {
+        return readOperator(in, key, op);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+/**
+ * @brief Persist an operator. It is written to a temporary file first, so that concurrent
+ * processes never read a partial file.
+ *
+ * @tparam T Type of the operator.
+ * @param file File.
+ * @param key Key of the operator.
+ * @param op Operator.
+ */
+template <typename T>
+void save(const std::string& file, const OperatorKey& key, const T& op)
+{
+    std::ostringstream suffix;
+    suffix << ".tmp." << getpid() << "." << std::this_thread::get_id();
+    const std::string tmp = file + suffix.str();
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(operatorMagic, sizeof(operatorMagic));
+        const std::string bytes = keyBytes(key);
+        out.write(bytes.data(), bytes.size());
+        writeOperator(out, op);
+        if (!out.good())
+        {
+            out.close();
+            std::filesystem::remove(tmp);
+            throw std::runtime_error("Unable to write file " + tmp);
+        }
+    }
+    std::filesystem::rename(tmp, file);
+}
+
+FactorizationCache::FactorizationCache(const std::string& directory, size_t budget) : budget(budget), bytes(0), uses(0), hitCount(0), missCount(0)
+{
+    setDirectory(directory);
+}
+
+FactorizationCache::~FactorizationCache()
+{
+}
+
+FactorizationCache& FactorizationCache::global()
+{
+    static FactorizationCache cache;
+    return cache;
+}
+
+void FactorizationCache::setDirectory(const std::string& directory)
+{
+    if (!directory.empty())
+    {
+        std::filesystem::create_directories(directory);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    this->directory = directory;
+}
+
+std::string FactorizationCache::path(const OperatorKey& key) const
+{
+    if (directory.empty())
+    {
+        return "";
+    }
+    // FNV-1a of the key. The key is also stored in the file, so a collision only costs a rebuild.
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : keyBytes(key))
+    {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    std::ostringstream name;
+    name << (key.plate ? "plate-" : "bar-") << std::hex << hash << ".op";
+    return (std::filesystem::path(directory) / name.str()).string();
+}
+
+void FactorizationCache::evict()
+{
+    while (bytes > budget)
+    {
+        const auto bar = leastRecentlyUsed(bars);
+        const auto plate = leastRecentlyUsed(plates);
+        if (bar == bars.end() && plate == plates.end())
+        {
+            return;
+        }
+        if (plate == plates.end() || (bar != bars.end() && bar->second.lastUse < plate->second.lastUse))
+        {
+            bytes -= bar->second.bytes;
+            bars.erase(bar);
+        }
+        else
+        {
+            bytes -= plate->second.bytes;
+            plates.erase(plate);
+        }
+    }
+}
+
+template <typename T>
+std::shared_ptr<const T> FactorizationCache::get(std::map<OperatorKey, Entry<T>>& entries, const OperatorKey& key, const std::function<void(T&)>& build)
+{
+    std::promise<std::shared_ptr<const T>> promise;
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end())
+    {
+        hitCount++;
+        it->second.lastUse = ++uses;
+        std::shared_future<std::shared_ptr<const T>> entry = it->second.op;
+        lock.unlock();
+        return entry.get();
+    }
+    const std::shared_future<std::shared_ptr<const T>> future = promise.get_future().share();
+    entries.emplace(key, Entry<T>{future, 0, ++uses});
+    const std::string file = path(key);
+    lock.unlock();
+
+    try
+    {
+        auto op = std::make_shared<T>();
+        const bool loaded = !file.empty() && load(file, key, *op);
+        if (!loaded)
+        {
+            build(*op);
+            if (!file.empty())
+            {
+                try
+                {
+                    save(file, key, *op);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Warning: operator not persisted: " << e.what() << std::endl;
+                }
+            }
+        }
+        lock.lock();
+        (loaded ? hitCount : missCount)++;
+        // The entry is gone if the cache was cleared meanwhile, and may then be built again by another caller:
+        // the operator is only counted once.
+        it = entries.find(key);
+        if (it != entries.end() && it->second.bytes == 0)
+        {
+            it->second.bytes = std::max<size_t>(operatorBytes(*op), 1);
+            bytes += it->second.bytes;
+        }
+        lock.unlock();
+        promise.set_value(op);
+        lock.lock();
+        evict();
+        lock.unlock();
+        return op;
+    }
+    catch (...)
+    {
+        lock.lock();
+        entries.erase(key);
+        lock.unlock();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+std::shared_ptr<const BandedMatrix> FactorizationCache::barOperator(const Bar& bar, size_t n, double dx, double dt)
+{
+    const Material &mat = Material::materials.at(bar.getMaterial());
+    const OperatorKey key = {false, mat.getThermalConductivity(), mat.getDensity(), mat.getSpecificHeatCapacity(), n, 1, dx, 0, dt};
+    return get<BandedMatrix>(bars, key, [&](BandedMatrix& A)
+    {
+        bar.makeOperator(n, dx, dt, A);
+        A.factorize();
+    });
+}
+
+std::shared_ptr<const AdiOperator> FactorizationCache::plateOperator(const Plate& plate, size_t nx, size_t ny, double dx, double dy, double dt)
+{
+    const Material &mat = Material::materials.at(plate.getMaterial());
+    const OperatorKey key = {true, mat.getThermalConductivity(), mat.getDensity(), mat.getSpecificHeatCapacity(), nx, ny, dx, dy, dt};
+    return get<AdiOperator>(plates, key, [&](AdiOperator& op)
+    {
+        plate.makeAdiOperator(nx, ny, dx, dy, dt, op);
+    });
+}
+
+void FactorizationCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    bars.clear();
+    plates.clear();
+    bytes = 0;
+}
+
+size_t FactorizationCache::memory() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+size_t FactorizationCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+size_t FactorizationCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
@@ -12,218 +12,246 @@
 #include "../header/computation.h"
 #include "../header/sdl.h"
 #include "../header/exn.h"
+#include "../header/binary.h"
+#include "../header/pipeline.h"
+#include "../header/profile.h"
+#include "../header/sink.h"
+#include "../header/solution.h"
+#ifdef HEAT_MPI
+#include "../header/distributed.h"
+#endif
 
 #include <map>
-#include <thread>
 #include <iostream>
 #include <fstream>
+#include <memory>
 
-void solveBar(const Bar &bar, const std::string& filename, bool nogui)
+Grid makeGrid(const Bar &bar, const RunOptions& options)
+{
+    ScopedPhase phase("grid");
+    return Grid(bar.getTMax(), options.nt, bar.getL(), options.nx);
+}
+
+Grid makeGrid(const Plate &plate, const RunOptions& options)
+{
+    ScopedPhase phase("grid");
+    return Grid(plate.getTMax(), options.nt, plate.getL(), options.nx, plate.getL(), options.ny == 0 ? options.nx : options.ny);
+}
+
+SolverOptions makeSolverOptions(const RunOptions& options)
+{
+    SolverOptions solverOptions;
+    solverOptions.every = options.every;
+    solverOptions.tolerance = options.tolerance;
+    solverOptions.scheme = options.scheme;
+    solverOptions.solver = options.solver;
+    solverOptions.smoother = options.smoother;
+    solverOptions.tileDepth = options.tileDepth;
+    return solverOptions;
+}
+
+/**
+ * @brief Print the statistics of a solve.
+ * 
+ * @param stats Statistics.
+ * @param options Options of the run.
+ */
+void printStats(const StepStats &stats, const RunOptions &options)
+{
+    std::cout << "Solution computed";
+    if (options.tolerance > 0)
+    {
+        std::cout << " in " << stats.steps << " time steps (" << stats.rejected << " rejected)";
+    }
+    if (stats.iterations > 0)
+    {
+        std::cout << " with " << stats.iterations << " linear solver iterations";
+    }
+    std::cout << "." << std::endl;
+}
+
+/**
+ * @brief Add an output to the sinks fed by the solver. If the pipeline is enabled, the output
+ * gets its own writer thread, so that formatting and writing overlap with solving.
+ * 
+ * @param sinks Sinks fed by the solver.
+ * @param sink Output.
+ * @param pipeline Writer threads of the run.
+ * @param depth Number of steps which can wait to be written, 0 to write from the solver thread.
+ */
+void addOutput(TeeSink &sinks, StepSink &sink, std::vector<std::unique_ptr<AsyncSink>> &pipeline, size_t depth)
+{
+    if (depth == 0)
+    {
+        sinks.add(sink);
+        return;
+    }
+    pipeline.push_back(std::make_unique<AsyncSink>(sink, depth));
+    sinks.add(*pipeline.back());
+}
+
+void solveBar(const Bar &bar, const RunOptions& options)
 {
     double tMax = bar.getTMax();
     double L = bar.getL();
-    
-    std::vector<double> time;
-    std::vector<double> position;
+    const Grid grid = makeGrid(bar, options);
 
-    double dt = tMax / 1000;
-    std::thread timeThread([&time, tMax, dt]()
-    {
-        for (double t = 0; t <= tMax; t += dt)
-        {
-            time.push_back(t);
-        }
-    });
-    std::thread positionThread([&position, L]()
+    std::ofstream file;
+    if (options.filename != "")
     {
-        for (double x = 0; x <= L; x += L / 1000)
-        {
-            position.push_back(x);
-        }
-    });
-    
-    timeThread.join();
-    positionThread.join();
-    
-    std::vector<std::vector<double>> sol(time.size(), std::vector<double>(position.size(), 0));
-    bar.solve(time, position, sol);
-
-    std::cout << "Solution computed." << std::endl;
-    if (filename != "")
-    {
-        std::ofstream file(filename);
+        file.open(options.filename);
         if (!file.is_open())
         {
-            throw std::runtime_error("Unable to open file " + filename);
+            throw std::runtime_error("Unable to open file " + options.filename);
         }
-        file << "Time/position,";
-        for (size_t i = 0; i < position.size(); i++)
-        {
-            file  << position[i] << ",";
-        }
-        file << std::endl;
-        
-        for (size_t i = 0; i < time.size(); i++)
-        {
-            file << time[i] << ",";
-            for (size_t j = 0; j < position.size(); j++)
-            {
-                file << sol[i][j] << ",";
-            }
-            file << std::endl;
-        }
-        file.close();
-        std::cout << "Solution saved in " << filename << std::endl;
     }
+    CsvSink fileSink(file, ",", "Time/position,", options.precision, options.formatThreads);
+    BinaryWriter binarySink(options.binaryFilename, {bar.getU0(), bar.getF(), L, tMax, grid.time.step(), bar.getMaterial()}, options.singlePrecision);
+    CsvSink consoleSink(std::cout, " ", "", options.precision, options.formatThreads);
+    Solution sol;
+    SolutionSink solSink(sol);
 
-    if (!nogui)
+    // Declared after the outputs, so that writer threads are joined before the outputs are destroyed.
+    TeeSink sinks;
+    std::vector<std::unique_ptr<AsyncSink>> pipeline;
+    if (options.filename != "")
     {
-        std::cout << "Displaying solution in GUI..." << std::endl;
-        std::cout << "Initializing SDL..." << std::endl;
-        Sdl::SdlBarRunWindow(bar, time, position, sol);
+        addOutput(sinks, fileSink, pipeline, options.pipelineDepth);
+    }
+    if (options.binaryFilename != "")
+    {
+        addOutput(sinks, binarySink, pipeline, options.pipelineDepth);
+    }
+    if (!options.nogui)
+    {
+        sinks.add(solSink);
     }
     else
     {
+        // Streamed while solving: the steps come before the messages of the end of the solve.
         std::cout << "Displaying solution in console..." << std::endl;
-        for (size_t i = 0; i < position.size(); i++)
-        {
-            std::cout << position[i] << " ";
-        }
-        std::cout << std::endl;
-        
-        for (size_t i = 0; i < time.size(); i++)
-        {
-            std::cout << time[i] << " ";
-            for (size_t j = 0; j < position.size(); j++)
-            {
-                std::cout << sol[i][j] << " ";
-            }
-            std::cout << std::endl;
-        }
+        addOutput(sinks, consoleSink, pipeline, options.pipelineDepth);
+    }
+
+    if (options.steady)
+    {
+        ScopedPhase phase("solve");
+        bar.solveSteady(grid, sinks, makeSolverOptions(options));
+        std::cout << "Steady state computed." << std::endl;
+    }
+    else
+    {
+        ScopedPhase phase("solve");
+        printStats(bar.solve(grid, sinks, makeSolverOptions(options)), options);
+    }
+    if (options.filename != "")
+    {
+        file.close();
+        std::cout << "Solution saved in " << options.filename << std::endl;
+    }
+    if (options.binaryFilename != "")
+    {
+        std::cout << "Solution saved in " << options.binaryFilename << std::endl;
+    }
+
+    if (!options.nogui)
+    {
+        std::cout << "Displaying solution in GUI..." << std::endl;
+        std::cout << "Initializing SDL..." << std::endl;
+        Sdl::SdlBarRunWindow(bar, solSink.times(), grid.x.points(), sol);
     }
 }
 
-void solvePlate(const Plate &plate, const std::string& filename, bool nogui)
+void solvePlate(const Plate &plate, const RunOptions& options)
 {
     double tMax = plate.getTMax();
     double L = plate.getL();
-    
-    std::vector<double> time;
-    std::vector<double> positionX;
-    std::vector<double> positionY;
-    std::vector<std::vector<double>> sol;
+    const Grid grid = makeGrid(plate, options);
 
-    double dt = tMax / 1000;
-    std::thread timeThread([&time, tMax, dt]()
+    if (options.distributed)
     {
-        for (double t = 0; t <= tMax; t += dt)
+#ifdef HEAT_MPI
+        if (options.scheme != Scheme::Explicit || options.tolerance > 0 || options.steady)
         {
-            time.push_back(t);
+            throw Exn("The distributed solver only supports fixed steps of the ftcs scheme.");
         }
-    });
-    std::thread positionXThread([&positionX, L]()
-    {
-        for (double x = 0; x <= L; x += L / 1000)
+        if (!options.nogui || options.filename != "")
         {
-            positionX.push_back(x);
+            throw Exn("The distributed solver only writes the binary output, use -n and -b.");
         }
-    });
-    std::thread positionYThread([&positionY, L]()
-    {
-        for (double y = 0; y <= L; y += L / 1000)
+        ScopedPhase phase("solve");
+        printStats(solveDistributed(plate, grid, options.binaryFilename, options.singlePrecision, makeSolverOptions(options)), options);
+        if (options.binaryFilename != "")
         {
-            positionY.push_back(y);
+            std::cout << "Solution saved in " << options.binaryFilename << std::endl;
         }
-    });
-    timeThread.join();
-    positionXThread.join();
-    positionYThread.join();
-
-    plate.solve(time, positionX, positionY, sol);
+        return;
+#else
+        throw Exn("This build has no MPI support, build it with make MPI=TRUE.");
+#endif
+    }
 
-    std::cout << "Solution computed." << std::endl;
-    if (filename != "")
+    std::ofstream file;
+    if (options.filename != "")
     {
-        std::ofstream file(filename);
+        file.open(options.filename);
         if (!file.is_open())
         {
-            throw std::runtime_error("Unable to open file " + filename);
+            throw std::runtime_error("Unable to open file " + options.filename);
         }
+    }
+    CsvSink fileSink(file, ",", "", options.precision, options.formatThreads);
+    BinaryWriter binarySink(options.binaryFilename, {plate.getU0(), plate.getF(), L, tMax, grid.time.step(), plate.getMaterial()}, options.singlePrecision);
+    CsvSink consoleSink(std::cout, ",", "", options.precision, options.formatThreads);
+    Solution sol;
+    SolutionSink solSink(sol);
 
-        for (size_t i = 0; i < positionX.size(); i++)
-        {
-            file << positionX[i] << ",";
-        }
-        file << std::endl;
-        
-        for (size_t i = 0; i < positionY.size(); i++)
-        {
-            file << positionY[i] << ",";
-        }
-        file << std::endl;
-        
-        for (size_t i = 0; i < time.size(); i++)
-        {
-            file << time[i] << ",";
-            for (size_t j = 0; j < positionX.size(); j++)
-            {
-                for (size_t k = 0; k < positionY.size(); k++)
-                {
-                    file << sol[i][j * positionY.size() + k] << ",";
-                }
-            }
-            file << std::endl;
-        }
-        file.close();
-        std::cout << "Solution saved in " << filename << std::endl;
+    // Declared after the outputs, so that writer threads are joined before the outputs are destroyed.
+    TeeSink sinks;
+    std::vector<std::unique_ptr<AsyncSink>> pipeline;
+    if (options.filename != "")
+    {
+        addOutput(sinks, fileSink, pipeline, options.pipelineDepth);
     }
-    if (!nogui)
+    if (options.binaryFilename != "")
     {
-        std::cout << "Displaying solution in GUI..." << std::endl;
-        std::cout << "Initializing SDL..." << std::endl;
-        std::vector<std::vector<std::vector<double>>> solForSDL;
-        for (size_t i = 0; i < time.size(); i++)
-        {
-            std::vector<std::vector<double>> solForSDLi;
-            for (size_t j = 0; j < positionX.size(); j++)
-            {
-                std::vector<double> solForSDLij;
-                for (size_t k = 0; k < positionY.size(); k++)
-                {
-                    solForSDLij.push_back(sol[i][j * positionY.size() + k]);
-                }
-                solForSDLi.push_back(solForSDLij);
-            }
-            solForSDL.push_back(solForSDLi);
-        }
-        Sdl::SdlBarRunWindow(plate, time, positionX, positionY, solForSDL);
+        addOutput(sinks, binarySink, pipeline, options.pipelineDepth);
+    }
+    if (!options.nogui)
+    {
+        sinks.add(solSink);
     }
     else
     {
+        // Streamed while solving: the steps come before the messages of the end of the solve.
         std::cout << "Displaying solution in console..." << std::endl;
-        for (size_t i = 0; i < positionX.size(); i++)
-        {
-            std::cout << positionX[i] << ",";
-        }
-        std::cout << std::endl;
-        
-        for (size_t i = 0; i < positionY.size(); i++)
-        {
-            std::cout << positionY[i] << ",";
-        }
-        std::cout << std::endl;
-        
-        for (size_t i = 0; i < time.size(); i++)
-        {
-            std::cout << time[i] << ",";
-            for (size_t j = 0; j < positionX.size(); j++)
-            {
-                for (size_t k = 0; k < positionY.size(); k++)
-                {
-                    std::cout << sol[i][j * positionY.size() + k] << ",";
-                }
-            }
-            std::cout << std::endl;
-        }
+        addOutput(sinks, consoleSink, pipeline, options.pipelineDepth);
+    }
+
+    if (options.steady)
+    {
+        ScopedPhase phase("solve");
+        plate.solveSteady(grid, sinks, makeSolverOptions(options));
+        std::cout << "Steady state computed." << std::endl;
+    }
+    else
+    {
+        ScopedPhase phase("solve");
+        printStats(plate.solve(grid, sinks, makeSolverOptions(options)), options);
+    }
+    if (options.filename != "")
+    {
+        file.close();
+        std::cout << "Solution saved in " << options.filename << std::endl;
+    }
+    if (options.binaryFilename != "")
+    {
+        std::cout << "Solution saved in " << options.binaryFilename << std::endl;
+    }
+    if (!options.nogui)
+    {
+        std::cout << "Displaying solution in GUI..." << std::endl;
+        std::cout << "Initializing SDL..." << std::endl;
+        Sdl::SdlBarRunWindow(plate, solSink.times(), grid.x.points(), grid.y.points(), sol);
     }
 }
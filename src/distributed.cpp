@@ -0,0 +1,372 @@
+/**
+ * @file distributed.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link distributed.h}.
+ * @version 0.1
+ * @date 2023-01-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/distributed.h"
+#include "../header/binary.h"
+#include "../header/exn.h"
+#include "../header/materials.h"
+#include "../header/parallel.h"
+#include "../header/profile.h"
+#include "../header/sink.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <mpi.h>
+
+MpiSession::MpiSession(int& argc, char**& argv) : rankIndex(0), rankCount(1)
+{
+    int provided;
+    if (MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided) != MPI_SUCCESS)
+    {
+        throw Exn("Unable to initialize MPI.");
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &rankIndex);
+    MPI_Comm_size(MPI_COMM_WORLD, &rankCount);
+}
+
+MpiSession::~MpiSession()
+{
+    MPI_Finalize();
+}
+
+/**
+ * @brief Derived datatype, freed on destruction.
+ *
+ */
+struct MpiType
+{
+    MPI_Datatype type = MPI_DATATYPE_NULL;
+
+    MpiType() = default;
+    MpiType(const MpiType&) = delete;
+    MpiType& operator=(const MpiType&) = delete;
+    ~MpiType()
+    {
+        if (type != MPI_DATATYPE_NULL)
+        {
+            MPI_Type_free(&type);
+        }
+    };
+};
+
+/**
+ * @brief Cut the plate on a 2D Cartesian grid of ranks, as square as possible, and get the tile of this rank.
+ *
+ * @param nx Number of points along x.
+ * @param ny Number of points along y.
+ * @param comm Communicator of the Cartesian grid, to free with MPI_Comm_free.
+ * @return Tile
+ * @throws Exn If a rank would own no point.
+ */
+Tile makeTile(size_t nx, size_t ny, MPI_Comm& comm)
+{
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    int dims[2] = {0, 0};
+    MPI_Dims_create(size, 2, dims);
+    // MPI_Dims_create sorts the dimensions in decreasing order: cut the longest axis the most.
+    if (nx < ny)
+    {
+        std::swap(dims[0], dims[1]);
+    }
+    if (nx < static_cast<size_t>(dims[0]) || ny < static_cast<size_t>(dims[1]))
+    {
+        throw Exn("The plate has less points than ranks along an axis.");
+    }
+    const int periods[2] = {0, 0};
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &comm);
+    int rank;
+    int coords[2];
+    MPI_Comm_rank(comm, &rank);
+    MPI_Cart_coords(comm, rank, 2, coords);
+
+    Tile tile;
+    tile.x0 = coords[0] * nx / dims[0];
+    tile.nx = (coords[0] + 1) * nx / dims[0] - tile.x0;
+    tile.y0 = coords[1] * ny / dims[1];
+    tile.ny = (coords[1] + 1) * ny / dims[1] - tile.y0;
+    MPI_Cart_shift(comm, 0, 1, &tile.west, &tile.east);
+    MPI_Cart_shift(comm, 1, 1, &tile.south, &tile.north);
+    return tile;
+}
+
+/**
+ * @brief Explicit sub-step on the points [jBegin, jEnd) x [kBegin, kEnd) of a tile stored with its halo,
+ * point (j, k) being at (j + 1) * (ny + 2) + k + 1.
+ *
+ * @param cur Values with their halo.
+ * @param next Result.
+ * @param C Source of the tile, without halo.
+ * @param ny Number of points of the tile along y.
+ * @param a Coefficient of the center.
+ * @param bx Coefficient of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param h Sub-step.
+ * @param jBegin First point along x.
+ * @param jEnd Last point along x, excluded.
+ * @param kBegin First point along y.
+ * @param kEnd Last point along y, excluded.
+ */
+void updateTile(const double* cur, double* next, const double* C, size_t ny, double a, double bx, double by, double h, size_t jBegin, size_t jEnd, size_t kBegin, size_t kEnd)
+{
+    const size_t stride = ny + 2;
+    for (size_t j = jBegin; j < jEnd; j++)
+    {
+        const double *c = cur + (j + 1) * stride + 1;
+        const double *w = c - stride;
+        const double *e = c + stride;
+        double *y = next + (j + 1) * stride + 1;
+        const double *s = C + j * ny;
+        for (size_t k = kBegin; k < kEnd; k++)
+        {
+            // The fused multiply-adds of stencil5, so that the result matches the shared memory solver.
+            y[k] = std::fma(a, c[k], std::fma(bx, w[k] + e[k], by * (c[k - 1] + c[k + 1])));
+            y[k] += h * s[k];
+        }
+    }
+}
+
+/**
+ * @brief Post the exchange of the halos of a tile.
+ *
+ * @param u Values with their halo.
+ * @param tile Tile.
+ * @param column Datatype of a column of the tile (nx values, ny + 2 apart).
+ * @param comm Communicator of the Cartesian grid.
+ * @param requests Requests of the exchange, to wait for.
+ */
+void startHaloExchange(double* u, const Tile& tile, MPI_Datatype column, MPI_Comm comm, MPI_Request requests[8])
+{
+    const size_t stride = tile.ny + 2;
+    const int rowCount = static_cast<int>(tile.ny);
+    double *firstRow = u + stride + 1;
+    double *lastRow = u + tile.nx * stride + 1;
+    MPI_Irecv(firstRow - stride, rowCount, MPI_DOUBLE, tile.west, 0, comm, &requests[0]);
+    MPI_Irecv(lastRow + stride, rowCount, MPI_DOUBLE, tile.east, 1, comm, &requests[1]);
+    MPI_Irecv(firstRow - 1, 1, column, tile.south, 2, comm, &requests[2]);
+    MPI_Irecv(firstRow + tile.ny, 1, column, tile.north, 3, comm, &requests[3]);
+    MPI_Isend(lastRow, rowCount, MPI_DOUBLE, tile.east, 0, comm, &requests[4]);
+    MPI_Isend(firstRow, rowCount, MPI_DOUBLE, tile.west, 1, comm, &requests[5]);
+    MPI_Isend(firstRow + tile.ny - 1, 1, column, tile.north, 2, comm, &requests[6]);
+    MPI_Isend(firstRow, 1, column, tile.south, 3, comm, &requests[7]);
+}
+
+/**
+ * @brief Result file written collectively: rank 0 writes the header and the times, and each step is
+ * written by all the ranks at once, each one through a view on its tile.
+ *
+ */
+class DistributedWriter
+{
+private:
+    std::string filename;
+    bool singlePrecision;
+    MPI_File file;
+    MpiType tileType;
+    std::vector<double> packed;
+    std::vector<float> packedSingle;
+public:
+    /**
+     * @brief Open the file and write its header.
+     *
+     * @param filename File to write.
+     * @param header Header of the file.
+     * @param times Time of each step.
+     * @param tile Tile of this rank.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    DistributedWriter(const std::string& filename, const BinaryHeader& header, const std::vector<double>& times, const Tile& tile) : filename(filename), singlePrecision(header.valueSize == sizeof(float)), file(MPI_FILE_NULL)
+    {
+        if constexpr (std::endian::native != std::endian::little)
+        {
+            throw std::runtime_error("Result files can only be written collectively on little-endian hosts.");
+        }
+        if (MPI_File_open(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+        {
+            throw std::runtime_error("Unable to open file " + filename);
+        }
+        MPI_File_set_size(file, 0);
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        int ok = 1;
+        if (rank == 0)
+        {
+            const BinaryHeader out = littleEndian(header);
+            ok = MPI_File_write_at(file, 0, &out, sizeof(out), MPI_BYTE, MPI_STATUS_IGNORE) == MPI_SUCCESS
+                && MPI_File_write_at(file, header.timesOffset, times.data(), static_cast<int>(times.size()), MPI_DOUBLE, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+        }
+        MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (!ok)
+        {
+            MPI_File_close(&file);
+            throw std::runtime_error("Unable to write file " + filename);
+        }
+
+        // The extent of the subarray is a whole step, so consecutive writes fill consecutive steps.
+        const MPI_Datatype value = singlePrecision ? MPI_FLOAT : MPI_DOUBLE;
+        const int sizes[2] = {static_cast<int>(header.sizeX), static_cast<int>(header.sizeY)};
+        const int subsizes[2] = {static_cast<int>(tile.nx), static_cast<int>(tile.ny)};
+        const int starts[2] = {static_cast<int>(tile.x0), static_cast<int>(tile.y0)};
+        MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, value, &tileType.type);
+        MPI_Type_commit(&tileType.type);
+        MPI_File_set_view(file, header.valuesOffset, value, tileType.type, "native", MPI_INFO_NULL);
+        packed.resize(tile.nx * tile.ny);
+        if (singlePrecision)
+        {
+            packedSingle.resize(tile.nx * tile.ny);
+        }
+    }
+    DistributedWriter(const DistributedWriter&) = delete;
+    DistributedWriter& operator=(const DistributedWriter&) = delete;
+    /**
+     * @brief Destroy the Distributed Writer object, closing the file.
+     *
+     */
+    ~DistributedWriter()
+    {
+        MPI_File_close(&file);
+    }
+
+    /**
+     * @brief Write the next step. Must be called by all the ranks.
+     *
+     * @param u Values of the tile with their halo.
+     * @param tile Tile.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void write(const double* u, const Tile& tile)
+    {
+        const size_t stride = tile.ny + 2;
+        for (size_t j = 0; j < tile.nx; j++)
+        {
+            std::copy(u + (j + 1) * stride + 1, u + (j + 1) * stride + 1 + tile.ny, packed.begin() + j * tile.ny);
+        }
+        int status;
+        if (singlePrecision)
+        {
+            std::copy(packed.begin(), packed.end(), packedSingle.begin());
+            status = MPI_File_write_all(file, packedSingle.data(), static_cast<int>(packedSingle.size()), MPI_FLOAT, MPI_STATUS_IGNORE);
+        }
+        else
+        {
+            status = MPI_File_write_all(file, packed.data(), static_cast<int>(packed.size()), MPI_DOUBLE, MPI_STATUS_IGNORE);
+        }
+        if (status != MPI_SUCCESS)
+        {
+            throw std::runtime_error("Unable to write file " + filename);
+        }
+        Profiler::count(Counter::BytesWritten, packed.size() * (singlePrecision ? sizeof(float) : sizeof(double)));
+    }
+};
+
+StepStats solveDistributed(const Plate& plate, const Grid& grid, const std::string& binaryFilename, bool singlePrecision, const SolverOptions& options)
+{
+    MPI_Comm comm;
+    const Tile tile = makeTile(grid.x.size(), grid.y.size(), comm);
+
+    const Material &mat = Material::materials[plate.getMaterial()];
+    const double alpha = plate.diffusivity();
+    const double bx = alpha / (grid.x.step() * grid.x.step());
+    const double by = alpha / (grid.y.step() * grid.y.step());
+    const double dt = grid.time.step();
+    const size_t subSteps = explicitSubSteps(dt, 1 / (2 * (bx + by)));
+    const double h = dt / subSteps;
+
+    const std::vector<double> &x = grid.x.points();
+    const std::vector<double> &y = grid.y.points();
+    std::vector<double> C(tile.nx * tile.ny);
+    for (size_t j = 0; j < tile.nx; j++)
+    {
+        for (size_t k = 0; k < tile.ny; k++)
+        {
+            C[j * tile.ny + k] = plate(x[tile.x0 + j], y[tile.y0 + k]) / (mat.getDensity() * mat.getSpecificHeatCapacity());
+        }
+    }
+    // The halo on the border of the plate is never received, so it keeps the temperature of the boundary.
+    const size_t stride = tile.ny + 2;
+    std::vector<double> cur((tile.nx + 2) * stride, plate.getU0());
+    std::vector<double> next(cur);
+
+    MpiType column;
+    MPI_Type_vector(static_cast<int>(tile.nx), 1, static_cast<int>(stride), MPI_DOUBLE, &column.type);
+    MPI_Type_commit(&column.type);
+
+    const std::vector<double> &time = grid.time.points();
+    const size_t nt = time.size();
+    std::unique_ptr<DistributedWriter> writer;
+    if (!binaryFilename.empty())
+    {
+        std::vector<double> times;
+        for (size_t i = 0; i < nt; i++)
+        {
+            if (isStreamed(i, nt, options.every))
+            {
+                times.push_back(time[i]);
+            }
+        }
+        const BinaryHeader header = makeBinaryHeader({plate.getU0(), plate.getF(), plate.getL(), plate.getTMax(), dt, plate.getMaterial()}, times.size(), x, y, singlePrecision);
+        writer = std::make_unique<DistributedWriter>(binaryFilename, header, times, tile);
+        writer->write(cur.data(), tile);
+    }
+
+    const double a = 1 - 2 * h * (bx + by);
+    const double hx = h * bx;
+    const double hy = h * by;
+    const size_t grain = std::max<size_t>(1, 16384 / tile.ny);
+    ScopedPhase phase("time loop");
+    StepStats stats;
+    for (size_t i = 0; i < nt - 1; i++)
+    {
+        ScopedPhase stepPhase("step");
+        for (size_t s = 0; s < subSteps; s++)
+        {
+            MPI_Request requests[8];
+            startHaloExchange(cur.data(), tile, column.type, comm, requests);
+            // The inner points do not read the halo, so they are computed while it is exchanged.
+            if (tile.nx > 2 && tile.ny > 2)
+            {
+                parallelFor(tile.nx - 2, [&](size_t jBegin, size_t jEnd)
+                {
+                    updateTile(cur.data(), next.data(), C.data(), tile.ny, a, hx, hy, h, jBegin + 1, jEnd + 1, 1, tile.ny - 1);
+                }, grain);
+            }
+            MPI_Waitall(8, requests, MPI_STATUSES_IGNORE);
+            updateTile(cur.data(), next.data(), C.data(), tile.ny, a, hx, hy, h, 0, 1, 0, tile.ny);
+            if (tile.nx > 1)
+            {
+                updateTile(cur.data(), next.data(), C.data(), tile.ny, a, hx, hy, h, tile.nx - 1, tile.nx, 0, tile.ny);
+            }
+            if (tile.nx > 2)
+            {
+                updateTile(cur.data(), next.data(), C.data(), tile.ny, a, hx, hy, h, 1, tile.nx - 1, 0, 1);
+                if (tile.ny > 1)
+                {
+                    updateTile(cur.data(), next.data(), C.data(), tile.ny, a, hx, hy, h, 1, tile.nx - 1, tile.ny - 1, tile.ny);
+                }
+            }
+            std::swap(cur, next);
+        }
+        stats.steps++;
+        Profiler::count(Counter::Steps);
+        if (writer && isStreamed(i + 1, nt, options.every))
+        {
+            writer->write(cur.data(), tile);
+        }
+    }
+    writer.reset();
+    MPI_Comm_free(&comm);
+    return stats;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file fft.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link fft.h}.
+ * @version 0.1
+ * @date 2023-01-12
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/fft.h"
+#include "../header/exn.h"
+
+#include <cmath>
+#include <utility>
+
+void fft(std::vector<std::complex<double>>& a, bool inverse)
+{
+    const size_t n = a.size();
+    if (n == 0 || (n & (n - 1)) != 0)
+    {
+        throw Exn("FFT size must be a power of 2.");
+    }
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            std::swap(a[i], a[j]);
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+        const double angle = 2 * M_PI / len * (inverse ? 1 : -1);
+        const std::complex<double> root(std::cos(angle), std::sin(angle));
+        for (size_t i = 0; i < n; i += len)
+        {
+            std::complex<double> w(1);
+            for (size_t j = 0; j < len / 2; j++)
+            {
+                const std::complex<double> u = a[i + j];
+                const std::complex<double> v = a[i + j + len / 2] * w;
+                a[i + j] = u + v;
+                a[i + j + len / 2] = u - v;
+                w *= root;
+            }
+        }
+    }
+    if (inverse)
+    {
+        for (std::complex<double> &value : a)
+        {
+            value /= static_cast<double>(n);
+        }
+    }
+}
+
+SineTransform::SineTransform(size_t n) : n(n), m(2 * (n + 1)), size(1)
+{
+    if ((m & (m - 1)) == 0)
+    {
+        size = m;
+        return;
+    }
+    // Bluestein: X_k = w_k sum_j (x_j w_j) conj(w_(k - j)) with w_k = exp(-i pi k^2 / m),
+    // a convolution computed with power-of-2 transforms.
+    while (size < 2 * m - 1)
+    {
+        size <<= 1;
+    }
+    chirp.resize(m);
+    for (size_t k = 0; k < m; k++)
+    {
+        // k^2 mod 2m keeps the angle accurate for large k.
+        const double angle = -M_PI * static_cast<double>((k * k) % (2 * m)) / m;
+        chirp[k] = std::complex<double>(std::cos(angle), std::sin(angle));
+    }
+    kernel.assign(size, 0.0);
+    kernel[0] = std::conj(chirp[0]);
+    for (size_t k = 1; k < m; k++)
+    {
+        kernel[k] = kernel[size - k] = std::conj(chirp[k]);
+    }
+    fft(kernel);
+}
+
+void SineTransform::apply(double* x, size_t stride, std::vector<std::complex<double>>& work) const
+{
+    // Odd extension: [0, x_0, ..., x_(n-1), 0, -x_(n-1), ..., -x_0], whose transform is -2 i y.
+    work.assign(size, 0.0);
+    const bool direct = chirp.empty();
+    for (size_t j = 0; j < n; j++)
+    {
+        const double value = x[j * stride];
+        if (direct)
+        {
+            work[j + 1] = value;
+            work[m - 1 - j] = -value;
+        }
+        else
+        {
+            work[j + 1] = value * chirp[j + 1];
+            work[m - 1 - j] = -value * chirp[m - 1 - j];
+        }
+    }
+    fft(work);
+    if (!direct)
+    {
+        for (size_t k = 0; k < size; k++)
+        {
+            work[k] *= kernel[k];
+        }
+        fft(work, true);
+        for (size_t k = 0; k <= n; k++)
+        {
+            work[k] *= chirp[k];
+        }
+    }
+    for (size_t k = 0; k < n; k++)
+    {
+        x[k * stride] = -work[k + 1].imag() / 2;
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * @file grid.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link grid.h}.
+ * @version 0.1
+ * @date 2023-01-10
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/grid.h"
+#include "../header/exn.h"
+
+Axis::Axis() : length(0), spacing(0)
+{
+}
+
+Axis::Axis(double length, size_t n) : length(length), spacing(0), values(n)
+{
+    if (n < 2)
+    {
+        throw Exn("An axis needs at least 2 points.");
+    }
+    // Each point is computed from its index, so that rounding errors do not accumulate.
+    spacing = length / (n - 1);
+    for (size_t i = 0; i < n - 1; i++)
+    {
+        values[i] = i * spacing;
+    }
+    values[n - 1] = length;
+}
+
+Grid::Grid()
+{
+}
+
+Grid::Grid(double tMax, size_t nt, double L, size_t nx, double W, size_t ny) : time(tMax, nt), x(L, nx)
+{
+    if (ny != 0)
+    {
+        y = Axis(W, ny);
+    }
+}
@@ -17,7 +17,14 @@
 #include "../header/exn.h"
 #include "../header/materials.h"
 #include "../header/bar.h"
+#include "../header/cache.h"
+#include "../header/parallel.h"
+#include "../header/profile.h"
 #include "../header/computation.h"
+#include "../header/sweep.h"
+#ifdef HEAT_MPI
+#include "../header/distributed.h"
+#endif
 
 using namespace std;
 
@@ -28,13 +35,36 @@ using namespace std;
 void printHelp(const char *arg)
 {
     cout << "Usage: " << arg << "[OPTIONS] <material> <u0> <tMax> <f> <L>" << endl;
+    cout << "       " << arg << "[OPTIONS] --sweep <jobs file>" << endl;
     cout << "OPTIONS:" << endl;
     cout << "  -h, --help\t\tDisplay this help message." << endl;
     cout << "  -v, --version\t\tDisplay version information." << endl;
     cout << "  -m, --material\tNew material to add." << endl;
     cout << "  -p, --plate\t\tPlate to use. If this option is used, then <W> is mandatory." << endl;
     cout << "  -f, --file\t\tOutput will also be written in the given file, using CSV notation." << endl;
+    cout << "  -b, --binary\t\tOutput will also be written in the given file, using the binary format." << endl;
+    cout << "      --float32\t\tValues are written as float32 in the binary file." << endl;
     cout << "  -n, --no-gui\t\tNo GUI will be displayed. Output will be in stdout." << endl;
+    cout << "      --precision\tNumber of significant digits of the text outputs (default: shortest exact representation)." << endl;
+    cout << "      --format-threads\tNumber of threads formatting the text outputs." << endl;
+    cout << "      --pipeline-depth\tNumber of steps waiting to be written by each output thread, 0 to write from the solver thread (default: 4)." << endl;
+    cout << "  -e, --every\t\tOnly one time step out of every <k> is written or displayed." << endl;
+    cout << "      --nt\t\tNumber of time points (default: 1001)." << endl;
+    cout << "      --nx\t\tNumber of space points along x (default: 1001)." << endl;
+    cout << "      --ny\t\tNumber of space points along y (default: as many as along x)." << endl;
+    cout << "      --steady\t\tOnly compute the equilibrium temperature, in a single solve." << endl;
+    cout << "      --scheme\t\tTime integration scheme: euler, cn (Crank-Nicolson, Peaceman-Rachford ADI for the plate) or ftcs (explicit, with stable sub-steps). Default: euler for the bar, cn for the plate." << endl;
+    cout << "      --adaptive\tAdaptive time steps, with the given tolerance on the relative error of each step." << endl;
+    cout << "      --solver\t\tLinear solver of the plate: direct (default, ADI or fast Poisson), mg (multigrid) or pcg (conjugate gradient)." << endl;
+    cout << "      --smoother\tSmoother of the multigrid cycles: gs (default, red-black Gauss-Seidel) or jacobi (weighted, tiled)." << endl;
+    cout << "      --tile-depth\tNumber of explicit sub-steps per pass over the plate (default: 0, chosen from the grid)." << endl;
+    cout << "      --threads\t\tNumber of threads of the plate solvers (default: one per hardware thread)." << endl;
+    cout << "  -s, --sweep		Solve the scenarios of the given file concurrently. Each line is: <bar|plate> <material> <u0> <tMax> <f> <L> [output]." << endl;
+    cout << "      --cache-dir\tFactorized operators are persisted in the given directory, and reused by later runs." << endl;
+    cout << "      --jobs		Number of threads of the sweep (default: one per hardware thread)." << endl;
+    cout << "      --distributed\tSolve the plate on all the MPI ranks, with the ftcs scheme (builds with MPI=TRUE only)." << endl;
+    cout << "      --profile\t\tTime the phases of the run and count its steps, solves, bytes written and allocations, reported on stderr at exit as a table or json." << endl;
+    cout << "      --trace\t\tTimeline of the phases of every thread, written at exit in the given file in the Chrome trace format (chrome://tracing, Perfetto)." << endl;
 }
 
 /**
@@ -48,21 +78,16 @@ void printHelp(const char *arg)
  * @param f Temperature of the source.
  * @param material Material
  * @param plate If the plate is used.
- * @param filename File to write output.
- * @param nogui If the GUI is used.
+ * @param options Options of the run.
  * @throws Exn If not enough arguments for material creation.
  */
-void parseArguments(int argc, char *argv[], double &u0, double &L, double &tMax, double &f, string &material, bool &plate, string &filename, bool &nogui)
+void parseArguments(int argc, char *argv[], double &u0, double &L, double &tMax, double &f, string &material, bool &plate, RunOptions &options)
 {
     if (argc == 1)
     {
         printHelp(argv[0]);
         exit(0);
     }
-    if (argc < 6)
-    {
-        throw Exn("Not enough arguments.");
-    }
     for (int i = 1; i < argc; i++)
     {
         if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
@@ -79,8 +104,10 @@ void parseArguments(int argc, char *argv[], double &u0, double &L, double &tMax,
         {
             plate = true;
         }
-        if (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--material") == 0)
+        else if (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--material") == 0)
         {
+            if (argc <= i + 4)
+                throw Exn("Not enough arguments.");
             string name = argv[i + 1];
             double lambda;
             if (!sscanf(argv[i + 2], "%lf", &lambda) || lambda < 0)
@@ -101,13 +128,175 @@ void parseArguments(int argc, char *argv[], double &u0, double &L, double &tMax,
         {
             if (argc == i + 1)
                 throw Exn("Not enough arguments.");
-            filename = argv[i + 1];
+            options.filename = argv[i + 1];
+            i++;
+            cout << "Output will also be written in \"" << options.filename << "\"." << endl;
+        }
+        else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--binary") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.binaryFilename = argv[i + 1];
             i++;
-            cout << "Output will also be written in \"" << filename << "\"." << endl;
+            cout << "Output will also be written in \"" << options.binaryFilename << "\"." << endl;
+        }
+        else if (strcmp(argv[i], "--float32") == 0)
+        {
+            options.singlePrecision = true;
         }
         else if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "-no-gui") == 0 || !strcmp(argv[i], "-ng") || !strcmp(argv[i], "--no-gui"))
         {
-            nogui = true;
+            options.nogui = true;
+        }
+        else if (strcmp(argv[i], "--precision") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%d", &options.precision) || options.precision < 0)
+                throw Exn("Invalid precision value.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--format-threads") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.formatThreads) || options.formatThreads == 0)
+                throw Exn("Invalid format-threads value.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--pipeline-depth") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.pipelineDepth))
+                throw Exn("Invalid pipeline-depth value.");
+            i++;
+        }
+        else if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--every") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.every) || options.every == 0)
+                throw Exn("Invalid every value.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--nt") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.nt) || options.nt < 2)
+                throw Exn("Invalid nt value, at least 2 points are needed.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--nx") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.nx) || options.nx < 2)
+                throw Exn("Invalid nx value, at least 2 points are needed.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--ny") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.ny) || options.ny < 2)
+                throw Exn("Invalid ny value, at least 2 points are needed.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--steady") == 0)
+        {
+            options.steady = true;
+        }
+        else if (strcmp(argv[i], "--scheme") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.scheme = parseScheme(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--solver") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.solver = parseLinearSolver(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--smoother") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.smoother = parseSmoother(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--tile-depth") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.tileDepth))
+                throw Exn("Invalid tile depth.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            size_t threads;
+            if (!sscanf(argv[i + 1], "%zu", &threads))
+                throw Exn("Invalid threads value.");
+            ParallelPool::setGlobalThreads(threads);
+            i++;
+        }
+        else if (strcmp(argv[i], "--adaptive") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%lf", &options.tolerance) || !(options.tolerance > 0))
+                throw Exn("Invalid adaptive tolerance.");
+            i++;
+        }
+        else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--sweep") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.sweepFilename = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "--cache-dir") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            FactorizationCache::global().setDirectory(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "--jobs") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            if (!sscanf(argv[i + 1], "%zu", &options.jobs))
+                throw Exn("Invalid jobs value.");
+            i++;
+        }
+        else if (strcmp(argv[i], "--distributed") == 0)
+        {
+            options.distributed = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.profile = argv[i + 1];
+            if (options.profile != "table" && options.profile != "json")
+                throw Exn("Unknown profile format, expected table or json.");
+            Profiler::global().enable();
+            i++;
+        }
+        else if (strcmp(argv[i], "--trace") == 0)
+        {
+            if (argc == i + 1)
+                throw Exn("Not enough arguments.");
+            options.traceFilename = argv[i + 1];
+            i++;
         }
         else if (material == "")
         {
@@ -145,27 +334,49 @@ void parseArguments(int argc, char *argv[], double &u0, double &L, double &tMax,
  */
 int main(int argc, char *argv[])
 {
+#ifdef HEAT_MPI
+    MpiSession mpi(argc, argv);
+    if (mpi.rank() != 0)
+    {
+        // Only the first rank prints, the others still report their errors.
+        cout.setstate(std::ios::badbit);
+    }
+#endif
     cout << "\t\t----- Heat Equation Solver -----" << endl;
     double u0 = -1, L = -1, tMax = -1, f = -1;
-    string material = "", filename = "";
+    string material = "";
     bool plate = false;
-    bool nogui = false;
+    RunOptions options;
+    int code = 0;
     try
     {
-        if (u0 < 0 || L < 0 || tMax < 0 || f < 0 || material == "")
+        parseArguments(argc, argv, u0, L, tMax, f, material, plate, options);
+        bool trace = !options.traceFilename.empty();
+#ifdef HEAT_MPI
+        // Each rank would write the same file, only the first one traces.
+        trace = trace && mpi.rank() == 0;
+#endif
+        if (trace)
+        {
+            TraceRecorder::global().enable(options.traceFilename);
+        }
+        if (!options.sweepFilename.empty())
+        {
+            code = runSweep(readJobFile(options.sweepFilename), options) == 0 ? 0 : 1;
+        }
+        else if (u0 < 0 || L < 0 || tMax < 0 || f < 0 || material == "")
         {
             throw Exn("Not enough arguments.");
         }
-        parseArguments(argc, argv, u0, L, tMax, f, material, plate, filename, nogui);
-        if (!plate)
+        else if (!plate)
         {
             Bar bar(u0, L, tMax, f, material);
-            solveBar(bar, filename, nogui);
+            solveBar(bar, options);
         }
         else
         {
             Plate plate(u0, L, tMax, f, material);
-            solvePlate(plate, filename, nogui);
+            solvePlate(plate, options);
         }
     }
     catch (const std::exception &e)
@@ -173,5 +384,26 @@ int main(int argc, char *argv[])
         std::cerr << e.what() << std::endl;
     }
 
-    return 0;
+    // The profile and the trace of a failed run are reported too, they tell where it stopped.
+    if (TraceRecorder::enabled())
+    {
+        try
+        {
+            TraceRecorder::global().write();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    bool report = Profiler::enabled();
+#ifdef HEAT_MPI
+    // Each rank profiles itself, only the first one reports.
+    report = report && mpi.rank() == 0;
+#endif
+    if (report)
+    {
+        Profiler::global().report(std::cerr, options.profile == "json");
+    }
+    return code;
 }
\ No newline at end of file
@@ -0,0 +1,313 @@
+/**
+ * @file matrix.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link matrix.h}.
+ * @version 0.1
+ * @date 2023-01-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/matrix.h"
+#include "../header/exn.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+#include <cstdint>
+
+Matrix::Matrix(size_t rows, size_t cols) : nRows(rows), nCols(cols)
+{
+}
+
+Matrix::~Matrix()
+{
+}
+
+DenseMatrix::DenseMatrix(size_t rows, size_t cols) : Matrix(rows, cols), data(rows * cols, 0.0)
+{
+}
+
+void DenseMatrix::multiply(const std::vector<double>& x, std::vector<double>& y) const
+{
+    if (x.size() != nCols)
+    {
+        throw Exn("Matrix and vector sizes do not match.");
+    }
+    y.assign(nRows, 0.0);
+    for (size_t i = 0; i < nRows; i++)
+    {
+        const double *r = row(i);
+        double tmp = 0.0;
+        for (size_t j = 0; j < nCols; j++)
+        {
+            tmp += r[j] * x[j];
+        }
+        y[i] = tmp;
+    }
+}
+
+BandedMatrix::BandedMatrix(size_t n, size_t kl, size_t ku) : Matrix(n, n), kl(kl), ku(ku), data(n * (kl + ku + 1), 0.0), factorized(false)
+{
+}
+
+double BandedMatrix::operator()(size_t i, size_t j) const
+{
+    if (j + kl < i || j > i + ku)
+    {
+        return 0.0;
+    }
+    return data[i * (kl + ku + 1) + j + kl - i];
+}
+
+void BandedMatrix::set(size_t i, size_t j, double value)
+{
+    if (factorized)
+    {
+        throw Exn("Matrix is factorized.");
+    }
+    if (i >= nRows || j >= nCols || j + kl < i || j > i + ku)
+    {
+        throw Exn("Coefficient is outside the band.");
+    }
+    data[i * (kl + ku + 1) + j + kl - i] = value;
+}
+
+void BandedMatrix::multiply(const std::vector<double>& x, std::vector<double>& y) const
+{
+    if (x.size() != nCols)
+    {
+        throw Exn("Matrix and vector sizes do not match.");
+    }
+    if (factorized)
+    {
+        throw Exn("Matrix is factorized.");
+    }
+    const size_t w = kl + ku + 1;
+    y.assign(nRows, 0.0);
+    for (size_t i = 0; i < nRows; i++)
+    {
+        const size_t jMin = i > kl ? i - kl : 0;
+        const size_t jMax = std::min(nCols - 1, i + ku);
+        double tmp = 0.0;
+        for (size_t j = jMin; j <= jMax; j++)
+        {
+            tmp += data[i * w + j + kl - i] * x[j];
+        }
+        y[i] = tmp;
+    }
+}
+
+void BandedMatrix::factorize()
+{
+    ScopedPhase phase("factorize");
+    if (factorized)
+    {
+        return;
+    }
+    const size_t w = kl + ku + 1;
+    for (size_t k = 0; k < nRows; k++)
+    {
+        const double pivot = data[k * w + kl];
+        if (pivot == 0.0)
+        {
+            throw Exn("Zero pivot in banded decomposition.");
+        }
+        const size_t iMax = std::min(nRows - 1, k + kl);
+        const size_t jMax = std::min(nCols - 1, k + ku);
+        for (size_t i = k + 1; i <= iMax; i++)
+        {
+            double &lik = data[i * w + k + kl - i];
+            lik /= pivot;
+            for (size_t j = k + 1; j <= jMax; j++)
+            {
+                data[i * w + j + kl - i] -= lik * data[k * w + j + kl - k];
+            }
+        }
+    }
+    factorized = true;
+}
+
+void BandedMatrix::solve(const std::vector<double>& b, std::vector<double>& x) const
+{
+    if (!factorized)
+    {
+        throw Exn("Matrix is not factorized.");
+    }
+    if (b.size() != nRows)
+    {
+        throw Exn("Matrix and vector sizes do not match.");
+    }
+    x.resize(nRows);
+    solve(b.data(), x.data());
+}
+
+void BandedMatrix::solve(const double* b, double* x) const
+{
+    Profiler::count(Counter::Solves);
+    if (!factorized)
+    {
+        throw Exn("Matrix is not factorized.");
+    }
+    const size_t w = kl + ku + 1;
+    const size_t n = nRows;
+    for (size_t i = 0; i < n; i++)
+    {
+        double tmp = b[i];
+        for (size_t j = i > kl ? i - kl : 0; j < i; j++)
+        {
+            tmp -= data[i * w + j + kl - i] * x[j];
+        }
+        x[i] = tmp;
+    }
+    for (size_t i = n; i >= 1; i--)
+    {
+        const size_t r = i - 1;
+        const size_t jMax = std::min(n - 1, r + ku);
+        double tmp = x[r];
+        for (size_t j = r + 1; j <= jMax; j++)
+        {
+            tmp -= data[r * w + j + kl - r] * x[j];
+        }
+        x[r] = tmp / data[r * w + kl];
+    }
+}
+
+void BandedMatrix::solve(const double* b, double* x, size_t count, size_t stride) const
+{
+    Profiler::count(Counter::Solves);
+    if (!factorized)
+    {
+        throw Exn("Matrix is not factorized.");
+    }
+    const size_t w = kl + ku + 1;
+    const size_t n = nRows;
+    for (size_t i = 0; i < n; i++)
+    {
+        double *xi = x + i * stride;
+        const double *bi = b + i * stride;
+        for (size_t c = 0; c < count; c++)
+        {
+            xi[c] = bi[c];
+        }
+        for (size_t j = i > kl ? i - kl : 0; j < i; j++)
+        {
+            const double lij = data[i * w + j + kl - i];
+            const double *xj = x + j * stride;
+            for (size_t c = 0; c < count; c++)
+            {
+                xi[c] -= lij * xj[c];
+            }
+        }
+    }
+    for (size_t i = n; i >= 1; i--)
+    {
+        const size_t r = i - 1;
+        const size_t jMax = std::min(n - 1, r + ku);
+        double *xr = x + r * stride;
+        for (size_t j = r + 1; j <= jMax; j++)
+        {
+            const double urj = data[r * w + j + kl - r];
+            const double *xj = x + j * stride;
+            for (size_t c = 0; c < count; c++)
+            {
+                xr[c] -= urj * xj[c];
+            }
+        }
+        const double pivot = data[r * w + kl];
+        for (size_t c = 0; c < count; c++)
+        {
+            xr[c] /= pivot;
+        }
+    }
+}
+
+void BandedMatrix::write(std::ostream& out) const
+{
+    const uint64_t header[4] = {nRows, kl, ku, factorized ? 1u : 0u};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(double));
+}
+
+void BandedMatrix::read(std::istream& in)
+{
+    uint64_t header[4];
+    if (!in.read(reinterpret_cast<char *>(header), sizeof(header)) || header[3] > 1 || header[1] > header[0] || header[2] > header[0])
+    {
+        throw Exn("Invalid banded matrix.");
+    }
+    std::vector<double> values(header[0] * (header[1] + header[2] + 1));
+    if (!in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(double)))
+    {
+        throw Exn("Invalid banded matrix.");
+    }
+    nRows = nCols = header[0];
+    kl = header[1];
+    ku = header[2];
+    factorized = header[3] == 1;
+    data = std::move(values);
+}
+
+CsrMatrix::CsrMatrix(size_t rows, size_t cols) : Matrix(rows, cols), rowPtr(rows + 1, 0)
+{
+}
+
+CsrMatrix::CsrMatrix(size_t rows, size_t cols, std::vector<Triplet> triplets) : Matrix(rows, cols), rowPtr(rows + 1, 0)
+{
+    std::sort(triplets.begin(), triplets.end(), [](const Triplet &a, const Triplet &b)
+    {
+        return a.row < b.row || (a.row == b.row && a.col < b.col);
+    });
+    colIdx.reserve(triplets.size());
+    values.reserve(triplets.size());
+    for (size_t k = 0; k < triplets.size(); k++)
+    {
+        const Triplet &t = triplets[k];
+        if (t.row >= rows || t.col >= cols)
+        {
+            throw Exn("Coefficient is out of the matrix.");
+        }
+        if (k > 0 && triplets[k - 1].row == t.row && triplets[k - 1].col == t.col)
+        {
+            values.back() += t.value;
+            continue;
+        }
+        colIdx.push_back(t.col);
+        values.push_back(t.value);
+        rowPtr[t.row + 1]++;
+    }
+    for (size_t i = 0; i < rows; i++)
+    {
+        rowPtr[i + 1] += rowPtr[i];
+    }
+}
+
+double CsrMatrix::operator()(size_t i, size_t j) const
+{
+    const auto begin = colIdx.begin() + rowPtr[i];
+    const auto end = colIdx.begin() + rowPtr[i + 1];
+    const auto it = std::lower_bound(begin, end, j);
+    if (it == end || *it != j)
+    {
+        return 0.0;
+    }
+    return values[it - colIdx.begin()];
+}
+
+void CsrMatrix::multiply(const std::vector<double>& x, std::vector<double>& y) const
+{
+    if (x.size() != nCols)
+    {
+        throw Exn("Matrix and vector sizes do not match.");
+    }
+    y.assign(nRows, 0.0);
+    for (size_t i = 0; i < nRows; i++)
+    {
+        double tmp = 0.0;
+        for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; k++)
+        {
+            tmp += values[k] * x[colIdx[k]];
+        }
+        y[i] = tmp;
+    }
+}
@@ -0,0 +1,412 @@
+/**
+ * @file multigrid.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link multigrid.h}.
+ * @version 0.1
+ * @date 2023-01-13
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/multigrid.h"
+#include "../header/exn.h"
+#include "../header/parallel.h"
+#include "../header/profile.h"
+#include "../header/tiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Fill the linear interpolation from a coarse axis to a fine axis. Both axes have a point
+ * outside of the grid at each end, where the values are 0, so point j of n is at (j + 1) / (n + 1).
+ *
+ * @param n Number of fine points.
+ * @param nc Number of coarse points.
+ * @param left Coarse point on the left of each fine point, -1 for the point outside of the grid.
+ * @param weight Weight of the coarse point on the right of each fine point.
+ */
+void makeInterpolation(size_t n, size_t nc, std::vector<long>& left, std::vector<double>& weight)
+{
+    left.resize(n);
+    weight.resize(n);
+    for (size_t j = 0; j < n; j++)
+    {
+        const size_t position = (j + 1) * (nc + 1);
+        left[j] = static_cast<long>(position / (n + 1)) - 1;
+        weight[j] = static_cast<double>(position % (n + 1)) / (n + 1);
+    }
+}
+
+/**
+ * @brief Euclidean norm.
+ *
+ * @param x Values.
+ * @param n Number of values.
+ * @return double
+ */
+double norm(const double* x, size_t n)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += x[i] * x[i];
+    }
+    return std::sqrt(sum);
+}
+
+/**
+ * @brief Scalar product.
+ *
+ * @param x Values.
+ * @param y Values.
+ * @param n Number of values.
+ * @return double
+ */
+double dot(const double* x, const double* y, size_t n)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Get the minimum number of rows of a parallel block, so that small levels run on one thread.
+ *
+ * @param ny Number of points of a row.
+ * @return size_t
+ */
+size_t rowGrain(size_t ny)
+{
+    return std::max<size_t>(1, 16384 / std::max<size_t>(ny, 1));
+}
+
+Smoother parseSmoother(const std::string& name)
+{
+    if (name == "gs" || name == "gauss-seidel")
+    {
+        return Smoother::GaussSeidel;
+    }
+    if (name == "jacobi")
+    {
+        return Smoother::Jacobi;
+    }
+    throw Exn("Unknown smoother, expected gs or jacobi.");
+}
+
+Multigrid::Multigrid(size_t nx, size_t ny, double bx, double by, double shift, size_t preSmooth, size_t postSmooth, Smoother smoother) : shift(shift), preSmooth(preSmooth), postSmooth(postSmooth), smoother(smoother)
+{
+    ScopedPhase phase("multigrid setup");
+    if (nx == 0 || ny == 0)
+    {
+        throw Exn("Multigrid needs at least one point.");
+    }
+    levels.push_back(Level{nx, ny, bx, by, {}, {}, std::vector<double>(nx * ny), {}, {}, {}, {}, 1, {}, {}, {}});
+    while (levels.back().nx > 3 || levels.back().ny > 3)
+    {
+        Level &fine = levels.back();
+        // Only the axes with a strong coupling are coarsened (semi-coarsening), since the smoother
+        // does not reduce the smooth errors along a weakly coupled axis.
+        const bool canX = fine.nx > 3;
+        const bool canY = fine.ny > 3;
+        const size_t ncx = canX && (2 * fine.bx >= fine.by || !canY) ? (fine.nx - 1) / 2 : fine.nx;
+        const size_t ncy = canY && (2 * fine.by >= fine.bx || !canX) ? (fine.ny - 1) / 2 : fine.ny;
+        makeInterpolation(fine.nx, ncx, fine.leftX, fine.weightX);
+        makeInterpolation(fine.ny, ncy, fine.leftY, fine.weightY);
+        // The spacing along an axis is proportional to 1 / (n + 1).
+        const double ratioX = static_cast<double>(ncx + 1) / (fine.nx + 1);
+        const double ratioY = static_cast<double>(ncy + 1) / (fine.ny + 1);
+        fine.scale = ratioX * ratioY;
+        fine.restrictedY.resize(fine.nx * ncy);
+        fine.rowsBegin.resize(ncx);
+        fine.rowsEnd.resize(ncx);
+        for (size_t c = 0; c < ncx; c++)
+        {
+            // leftX is sorted: the fine points of c are the ones whose left point is c - 1 or c.
+            const long cl = static_cast<long>(c);
+            fine.rowsBegin[c] = std::lower_bound(fine.leftX.begin(), fine.leftX.end(), cl - 1) - fine.leftX.begin();
+            fine.rowsEnd[c] = std::upper_bound(fine.leftX.begin(), fine.leftX.end(), cl) - fine.leftX.begin();
+        }
+        const size_t n = ncx * ncy;
+        levels.push_back(Level{ncx, ncy, fine.bx * ratioX * ratioX, fine.by * ratioY * ratioY, std::vector<double>(n), std::vector<double>(n), std::vector<double>(n), {}, {}, {}, {}, 1, {}, {}, {}});
+    }
+
+    const Level &last = levels.back();
+    const size_t n = last.nx * last.ny;
+    coarsest = BandedMatrix(n, last.ny, last.ny);
+    for (size_t j = 0; j < last.nx; j++)
+    {
+        for (size_t k = 0; k < last.ny; k++)
+        {
+            const size_t row = j * last.ny + k;
+            coarsest.set(row, row, shift + 2 * last.bx + 2 * last.by);
+            if (j > 0)
+            {
+                coarsest.set(row, row - last.ny, -last.bx);
+            }
+            if (j < last.nx - 1)
+            {
+                coarsest.set(row, row + last.ny, -last.bx);
+            }
+            if (k > 0)
+            {
+                coarsest.set(row, row - 1, -last.by);
+            }
+            if (k < last.ny - 1)
+            {
+                coarsest.set(row, row + 1, -last.by);
+            }
+        }
+    }
+    coarsest.factorize();
+}
+
+void Multigrid::gaussSeidel(const Level& level, double* x, const double* b, bool redFirst) const
+{
+    const size_t nx = level.nx;
+    const size_t ny = level.ny;
+    const double inverse = 1 / (shift + 2 * level.bx + 2 * level.by);
+    for (size_t color = 0; color < 2; color++)
+    {
+        // The points of a color only depend on the other color, so the rows can be updated concurrently.
+        const size_t parity = redFirst ? color : 1 - color;
+        parallelFor(nx, [&](size_t jBegin, size_t jEnd)
+        {
+            for (size_t j = jBegin; j < jEnd; j++)
+            {
+                double *row = x + j * ny;
+                const double *west = j > 0 ? row - ny : nullptr;
+                const double *east = j < nx - 1 ? row + ny : nullptr;
+                for (size_t k = (j + parity) % 2; k < ny; k += 2)
+                {
+                    const double w = west ? west[k] : 0;
+                    const double e = east ? east[k] : 0;
+                    const double s = k > 0 ? row[k - 1] : 0;
+                    const double n = k < ny - 1 ? row[k + 1] : 0;
+                    row[k] = (b[j * ny + k] + level.bx * (w + e) + level.by * (s + n)) * inverse;
+                }
+            }
+        }, rowGrain(ny));
+    }
+}
+
+void Multigrid::smooth(size_t l, double* x, const double* b, size_t sweeps, bool pre)
+{
+    Level &level = levels[l];
+    if (smoother == Smoother::Jacobi)
+    {
+        // The residual buffer is free until the smoothing is done.
+        jacobiSweeps(x, b, level.r.data(), level.nx, level.ny, shift, level.bx, level.by, 0.8, sweeps, workspace);
+        return;
+    }
+    for (size_t i = 0; i < sweeps; i++)
+    {
+        gaussSeidel(level, x, b, pre);
+    }
+}
+
+void Multigrid::residual(const Level& level, const double* x, const double* b, double* r) const
+{
+    const size_t ny = level.ny;
+    parallelFor(level.nx, [&](size_t jBegin, size_t jEnd)
+    {
+        stencil5(x, r, level.nx, ny, shift + 2 * level.bx + 2 * level.by, -level.bx, -level.by, 0, jBegin, jEnd);
+        for (size_t i = jBegin * ny; i < jEnd * ny; i++)
+        {
+            r[i] = b[i] - r[i];
+        }
+    }, rowGrain(ny));
+}
+
+void Multigrid::restrictResidual(size_t l)
+{
+    // Transpose of the interpolation, scaled by the ratio of the cell areas (full weighting when nested).
+    // It is applied along y then along x, so that each output row is written by a single thread.
+    Level &fine = levels[l];
+    Level &coarse = levels[l + 1];
+    const size_t ny = fine.ny;
+    const long ncy = static_cast<long>(coarse.ny);
+    parallelFor(fine.nx, [&](size_t jBegin, size_t jEnd)
+    {
+        for (size_t j = jBegin; j < jEnd; j++)
+        {
+            double *out = fine.restrictedY.data() + j * ncy;
+            const double *in = fine.r.data() + j * ny;
+            std::fill(out, out + ncy, 0.0);
+            for (size_t k = 0; k < ny; k++)
+            {
+                const long ly = fine.leftY[k];
+                const double wy = fine.weightY[k];
+                if (ly >= 0)
+                {
+                    out[ly] += (1 - wy) * in[k];
+                }
+                if (ly + 1 < ncy && wy != 0)
+                {
+                    out[ly + 1] += wy * in[k];
+                }
+            }
+        }
+    }, rowGrain(ny));
+    parallelFor(coarse.nx, [&](size_t cBegin, size_t cEnd)
+    {
+        for (size_t c = cBegin; c < cEnd; c++)
+        {
+            double *out = coarse.b.data() + c * ncy;
+            std::fill(out, out + ncy, 0.0);
+            for (size_t j = fine.rowsBegin[c]; j < fine.rowsEnd[c]; j++)
+            {
+                const long lx = fine.leftX[j];
+                const double wx = fine.weightX[j];
+                const double weight = fine.scale * (lx == static_cast<long>(c) ? 1 - wx : wx);
+                const double *in = fine.restrictedY.data() + j * ncy;
+                for (long k = 0; k < ncy; k++)
+                {
+                    out[k] += weight * in[k];
+                }
+            }
+        }
+    }, rowGrain(coarse.ny));
+}
+
+void Multigrid::prolongCorrection(size_t l, double* x) const
+{
+    const Level &fine = levels[l];
+    const Level &coarse = levels[l + 1];
+    const long ncx = static_cast<long>(coarse.nx);
+    const long ncy = static_cast<long>(coarse.ny);
+    auto at = [&](long cx, long cy) -> double
+    {
+        return cx < 0 || cx >= ncx || cy < 0 || cy >= ncy ? 0 : coarse.x[cx * ncy + cy];
+    };
+    parallelFor(fine.nx, [&](size_t jBegin, size_t jEnd)
+    {
+        for (size_t j = jBegin; j < jEnd; j++)
+        {
+            const long lx = fine.leftX[j];
+            const double wx = fine.weightX[j];
+            for (size_t k = 0; k < fine.ny; k++)
+            {
+                const long ly = fine.leftY[k];
+                const double wy = fine.weightY[k];
+                x[j * fine.ny + k] += (1 - wx) * ((1 - wy) * at(lx, ly) + wy * at(lx, ly + 1))
+                    + wx * ((1 - wy) * at(lx + 1, ly) + wy * at(lx + 1, ly + 1));
+            }
+        }
+    }, rowGrain(fine.ny));
+}
+
+void Multigrid::cycle(size_t l, double* x, const double* b)
+{
+    const Level &level = levels[l];
+    if (l + 1 == levels.size())
+    {
+        coarsest.solve(b, x);
+        return;
+    }
+    smooth(l, x, b, preSmooth, true);
+    residual(level, x, b, levels[l].r.data());
+    restrictResidual(l);
+    Level &coarse = levels[l + 1];
+    std::fill(coarse.x.begin(), coarse.x.end(), 0.0);
+    cycle(l + 1, coarse.x.data(), coarse.b.data());
+    prolongCorrection(l, x);
+    smooth(l, x, b, postSmooth, false);
+}
+
+void Multigrid::apply(const double* x, double* y) const
+{
+    const Level &level = levels.front();
+    parallelFor(level.nx, [&](size_t jBegin, size_t jEnd)
+    {
+        stencil5(x, y, level.nx, level.ny, shift + 2 * level.bx + 2 * level.by, -level.bx, -level.by, 0, jBegin, jEnd);
+    }, rowGrain(level.ny));
+}
+
+void Multigrid::vcycle(const double* b, double* x)
+{
+    cycle(0, x, b);
+}
+
+size_t Multigrid::solve(const std::vector<double>& b, std::vector<double>& x, double tolerance, size_t maxCycles)
+{
+    Profiler::count(Counter::Solves);
+    const Level &level = levels.front();
+    const size_t n = level.nx * level.ny;
+    if (b.size() != n)
+    {
+        throw Exn("Right-hand side does not match the grid.");
+    }
+    x.resize(n);
+    const double target = tolerance * norm(b.data(), n);
+    Workspace::Frame frame(workspace);
+    double *r = frame.take(n);
+    for (size_t cycles = 0; cycles <= maxCycles; cycles++)
+    {
+        residual(level, x.data(), b.data(), r);
+        if (norm(r, n) <= target)
+        {
+            return cycles;
+        }
+        if (cycles < maxCycles)
+        {
+            vcycle(b.data(), x.data());
+        }
+    }
+    throw Exn("Multigrid did not converge.");
+}
+
+size_t Multigrid::solveCg(const std::vector<double>& b, std::vector<double>& x, double tolerance, size_t maxIterations)
+{
+    Profiler::count(Counter::Solves);
+    const Level &level = levels.front();
+    const size_t n = level.nx * level.ny;
+    if (b.size() != n)
+    {
+        throw Exn("Right-hand side does not match the grid.");
+    }
+    x.resize(n);
+    const double target = tolerance * norm(b.data(), n);
+    Workspace::Frame frame(workspace);
+    double *r = frame.take(n);
+    double *z = frame.take(n);
+    double *p = frame.take(n);
+    double *q = frame.take(n);
+    residual(level, x.data(), b.data(), r);
+    std::fill(z, z + n, 0.0);
+    vcycle(r, z);
+    std::copy(z, z + n, p);
+    double rz = dot(r, z, n);
+    for (size_t iterations = 0; iterations <= maxIterations; iterations++)
+    {
+        if (norm(r, n) <= target)
+        {
+            return iterations;
+        }
+        if (iterations == maxIterations)
+        {
+            break;
+        }
+        apply(p, q);
+        const double alpha = rz / dot(p, q, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
+        std::fill(z, z + n, 0.0);
+        vcycle(r, z);
+        const double rzNext = dot(r, z, n);
+        const double beta = rzNext / rz;
+        rz = rzNext;
+        for (size_t i = 0; i < n; i++)
+        {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+    throw Exn("Conjugate gradient did not converge.");
+}
@@ -0,0 +1,177 @@
+/**
+ * @file parallel.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link parallel.h}.
+ * @version 0.1
+ * @date 2023-01-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/parallel.h"
+
+#include <algorithm>
+
+/**
+ * @brief Whether the current thread runs a block of a loop.
+ *
+ */
+thread_local bool inParallelLoop = false;
+
+ParallelPool::ParallelPool(size_t threads) : body(nullptr), n(0), blocks(0), generation(0), remaining(0), stop(false)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t w = 1; w < threads; w++)
+    {
+        workers.emplace_back(&ParallelPool::run, this, w);
+    }
+}
+
+ParallelPool::~ParallelPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ParallelPool::run(size_t worker)
+{
+    inParallelLoop = true;
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        start.wait(lock, [&]() { return stop || generation != seen; });
+        if (stop)
+        {
+            return;
+        }
+        seen = generation;
+        const BlockFunction *task = body;
+        const size_t count = n;
+        const size_t parts = blocks;
+        lock.unlock();
+        if (worker < parts)
+        {
+            try
+            {
+                (*task)(worker * count / parts, (worker + 1) * count / parts);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> errorLock(mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+        lock.lock();
+        if (--remaining == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
+
+void ParallelPool::parallelFor(size_t count, BlockFunction task, size_t grain)
+{
+    const size_t parts = std::min(size(), count / std::max<size_t>(grain, 1));
+    if (parts <= 1 || inParallelLoop)
+    {
+        task(0, count);
+        return;
+    }
+    std::unique_lock<std::mutex> busyLock(busy, std::try_to_lock);
+    if (!busyLock.owns_lock())
+    {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = &task;
+        n = count;
+        blocks = parts;
+        remaining = workers.size();
+        error = nullptr;
+        generation++;
+    }
+    start.notify_all();
+
+    std::exception_ptr own;
+    inParallelLoop = true;
+    try
+    {
+        task(0, count / parts);
+    }
+    catch (...)
+    {
+        own = std::current_exception();
+    }
+    inParallelLoop = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return remaining == 0; });
+    if (!own)
+    {
+        own = error;
+    }
+    error = nullptr;
+    lock.unlock();
+    if (own)
+    {
+        std::rethrow_exception(own);
+    }
+}
+
+/**
+ * @brief Get the team of the solvers, and the mutex guarding its creation.
+ *
+ * @return std::pair<std::unique_ptr<ParallelPool>&, std::mutex&>
+ */
+std::pair<std::unique_ptr<ParallelPool>&, std::mutex&> globalPool()
+{
+    static std::unique_ptr<ParallelPool> pool;
+    static std::mutex mutex;
+    return {pool, mutex};
+}
+
+ParallelPool& ParallelPool::global()
+{
+    auto [pool, mutex] = globalPool();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pool)
+    {
+        pool = std::make_unique<ParallelPool>();
+    }
+    return *pool;
+}
+
+void ParallelPool::setGlobalThreads(size_t threads)
+{
+    auto [pool, mutex] = globalPool();
+    std::lock_guard<std::mutex> lock(mutex);
+    pool = std::make_unique<ParallelPool>(threads);
+}
+
+void firstTouch(FirstTouchVector& buffer, size_t rows, size_t rowSize, double value)
+{
+    buffer.resize(rows * rowSize);
+    double *data = buffer.data();
+    parallelFor(rows, [&](size_t begin, size_t end)
+    {
+        std::fill(data + begin * rowSize, data + end * rowSize, value);
+    });
+}
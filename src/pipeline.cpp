@@ -0,0 +1,96 @@
+/**
+ * @file pipeline.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link pipeline.h}.
+ * @version 0.1
+ * @date 2023-01-07
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/pipeline.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+
+AsyncSink::AsyncSink(StepSink& sink, size_t depth) : sink(sink), depth(std::max<size_t>(1, depth)), nx(0), ny(0), fullSlots(this->depth + 1), freeSlots(this->depth + 1)
+{
+}
+
+AsyncSink::~AsyncSink()
+{
+    if (writer.joinable())
+    {
+        fullSlots.push({0, 0, 0.0, true});
+        writer.join();
+    }
+}
+
+void AsyncSink::begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY)
+{
+    sink.begin(steps, positionX, positionY);
+    nx = positionX.size();
+    ny = positionY.empty() ? 1 : positionY.size();
+    slots.resize(depth, nx, ny);
+    for (size_t s = 0; s < depth; s++)
+    {
+        freeSlots.push(s);
+    }
+    error = nullptr;
+    writer = std::thread(&AsyncSink::run, this);
+}
+
+void AsyncSink::consume(size_t i, double t, ConstStepView step)
+{
+    size_t slot;
+    {
+        // The solver stalls here when the writer thread falls behind.
+        ScopedPhase phase("pipeline/wait");
+        freeSlots.pop(slot);
+    }
+    std::copy(step.begin(), step.end(), slots[slot].begin());
+    fullSlots.push({slot, i, t, false});
+}
+
+void AsyncSink::end()
+{
+    fullSlots.push({0, 0, 0.0, true});
+    writer.join();
+    // Slots are all back in the free queue: drain it for a next stream.
+    size_t slot;
+    while (freeSlots.tryPop(slot))
+    {
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    sink.end();
+}
+
+void AsyncSink::run()
+{
+    Item item;
+    while (true)
+    {
+        fullSlots.pop(item);
+        if (item.last)
+        {
+            return;
+        }
+        // After a failure, steps are still drained so that the solver never blocks.
+        if (!error)
+        {
+            try
+            {
+                sink.consume(item.i, item.t, ConstStepView(slots[item.slot].data(), nx, ny));
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+        freeSlots.push(item.slot);
+    }
+}
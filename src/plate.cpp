@@ -10,32 +10,127 @@
  */
 
 #include "../header/plate.h"
+#include "../header/cache.h"
 #include "../header/materials.h"
 #include "../header/sdl.h"
 #include "../header/exn.h"
+#include "../header/fft.h"
+#include "../header/heatsolver.h"
+#include "../header/multigrid.h"
+#include "../header/parallel.h"
+#include "../header/profile.h"
+#include "../header/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <utility>
 
 /**
- * @brief Compute the C vector (second member of the equation).
+ * @brief Compute the C vector (source term of the equation, divided by rho * cp).
  * 
  * @param positionX Vector of the position along X.
  * @param positionY Vector of the position along Y.
  * @param mat Material.
  * @param plate Plate.
- * @param C Vector to fill.
- * @throws Exception if positionX and positionY have different size.
+ * @param C Vector to fill, point (j, k) being stored at j * positionY.size() + k.
  */
-void makeC(const std::vector<double>& positionX, const std::vector<double> positionY, const Material& mat, const Plate& plate, std::vector<double>& C)
+void makeC(const std::vector<double>& positionX, const std::vector<double>& positionY, const Material& mat, const Plate& plate, std::vector<double>& C)
 {
-    if (positionX.size() != positionY.size())
+    const size_t ny = positionY.size();
+    C.clear();
+    C.resize(positionX.size() * ny);
+    for (size_t j = 0; j < positionX.size(); j++)
     {
-        throw Exn("Position along x and along y must have the same size.");
+        for (size_t k = 0; k < ny; k++)
+        {
+            C[j * ny + k] = plate(positionX[j], positionY[k]) / (mat.getDensity() * mat.getSpecificHeatCapacity());
+        }
     }
-    C.clear();
-    C.resize(positionX.size());
-    for (size_t i = 0; i < positionX.size(); i++)
+}
+
+/**
+ * @brief Get the axes of the plate for its split operator.
+ * 
+ * @param op Operator.
+ * @param bx Diffusivity divided by dx^2.
+ * @param by Diffusivity divided by dy^2.
+ * @return std::array<HeatAxis<double>, 2> Axis x, then axis y.
+ */
+std::array<HeatAxis<double>, 2> adiAxes(const AdiOperator& op, double bx, double by)
+{
+    return {
+        HeatAxis<double>{{op.lx.data(), op.ux.data(), op.upperX.data(), 1, op.ux.size()}, bx},
+        HeatAxis<double>{{op.ly.data(), op.uy.data(), op.upperY.data(), 1, op.uy.size()}, by}
+    };
+}
+
+/**
+ * @brief Advance the plate by one step of a scheme, solving the whole 5-point system with an iterative solver
+ * instead of splitting it by direction. With v = u - u0, which is 0 outside of the plate, the implicit Euler
+ * step is (1 / dt - L) v' = v / dt + C, and the Crank-Nicolson step (1 / dt - L / 2) v' = (1 / dt + L / 2) v + C.
+ * 
+ * @tparam S Scheme, Euler or CrankNicolson.
+ * @param mg Multigrid solver, for bx, by (halved for Crank-Nicolson) and a shift of 1 / dt.
+ * @param options Options of the solve (solver, linear tolerance).
+ * @param dt Time step.
+ * @param u0 Temperature of the boundary.
+ * @param C Source term.
+ * @param cur Current values.
+ * @param rhs Right-hand side.
+ * @param v Values shifted by u0.
+ * @param next Next values, may be cur.
+ * @return size_t Number of iterations of the linear solver.
+ */
+template <Scheme S>
+size_t iterativeStep(Multigrid& mg, const SolverOptions& options, double dt, double u0, const std::vector<double>& C, const std::vector<double>& cur, std::vector<double>& rhs, std::vector<double>& v, std::vector<double>& next)
+{
+    const size_t n = cur.size();
+    rhs.resize(n);
+    v.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        v[i] = cur[i] - u0;
+    }
+    if constexpr (S == Scheme::CrankNicolson)
+    {
+        // (1 / dt + L / 2) v = 2 v / dt - (1 / dt - L / 2) v.
+        mg.apply(v.data(), rhs.data());
+        for (size_t i = 0; i < n; i++)
+        {
+            rhs[i] = 2 * v[i] / dt - rhs[i] + C[i];
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            rhs[i] = v[i] / dt + C[i];
+        }
+    }
+    // The current values are the initial guess.
+    const size_t iterations = options.solver == LinearSolver::ConjugateGradient
+        ? mg.solveCg(rhs, v, options.linearTolerance)
+        : mg.solve(rhs, v, options.linearTolerance);
+    next.resize(n);
+    for (size_t i = 0; i < n; i++)
     {
-        C[i] = 1 / (mat.getDensity() * mat.getSpecificHeatCapacity() * plate(positionX[i], positionY[i]));
+        next[i] = v[i] + u0;
     }
+    return iterations;
+}
+
+double Plate::diffusivity() const
+{
+    const Material &mat = Material::materials[material];
+    return mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity());
+}
+
+double Plate::operatorStep(Scheme scheme, double dt)
+{
+    return scheme == Scheme::CrankNicolson ? dt : 2 * dt;
 }
 
 Plate::Plate(double u0, double L, double tMax, double f, const std::string& material) : u0(u0), L(L), tMax(tMax), f(f), material(material)
@@ -62,7 +157,307 @@ Plate::~Plate()
 {
 }
 
-void Plate::solve(const std::vector<double>& time, const std::vector<double>& positionX, const std::vector<double>& positionY, std::vector<std::vector<double>>& sol) const
+void Plate::makeOperator(size_t nx, size_t ny, double dx, double dy, double dt, CsrMatrix& A) const
+{
+    ScopedPhase phase("assembly");
+    const Material &mat = Material::materials[material];
+    const double k = mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity());
+    const double bx = k / (dx * dx);
+    const double by = k / (dy * dy);
+    const double a = - (2 * bx + 2 * by + 1 / dt);
+
+    std::vector<Triplet> triplets;
+    triplets.reserve(5 * nx * ny);
+    for (size_t j = 0; j < nx; j++)
+    {
+        for (size_t l = 0; l < ny; l++)
+        {
+            const size_t row = j * ny + l;
+            triplets.push_back({row, row, a});
+            if (j > 0)
+            {
+                triplets.push_back({row, row - ny, bx});
+            }
+            if (j < nx - 1)
+            {
+                triplets.push_back({row, row + ny, bx});
+            }
+            if (l > 0)
+            {
+                triplets.push_back({row, row - 1, by});
+            }
+            if (l < ny - 1)
+            {
+                triplets.push_back({row, row + 1, by});
+            }
+        }
+    }
+    A = CsrMatrix(nx * ny, nx * ny, std::move(triplets));
+}
+
+void Plate::steadyState(const Grid& grid, std::vector<double>& u, const SolverOptions& options) const
+{
+    ScopedPhase phase("steady state");
+    const Material &mat = Material::materials[material];
+    const size_t nx = grid.x.size();
+    const size_t ny = grid.y.size();
+    const double alpha = diffusivity();
+    const double bx = alpha / (grid.x.step() * grid.x.step());
+    const double by = alpha / (grid.y.step() * grid.y.step());
+
+    if (options.solver != LinearSolver::Direct)
+    {
+        // -(Lx + Ly) v = C, with v = u - u0.
+        Multigrid mg(nx, ny, bx, by, 0, 2, 2, options.smoother);
+        std::vector<double> C;
+        makeC(grid.x.points(), grid.y.points(), mat, *this, C);
+        u.assign(nx * ny, 0.0);
+        if (options.solver == LinearSolver::ConjugateGradient)
+        {
+            mg.solveCg(C, u, options.linearTolerance);
+        }
+        else
+        {
+            mg.solve(C, u, options.linearTolerance);
+        }
+        for (double &value : u)
+        {
+            value += u0;
+        }
+        return;
+    }
+
+    // With v = u - u0, (Lx + Ly) v = -C and v = 0 outside of the plate. The sine transform along x
+    // diagonalizes Lx, which leaves one tridiagonal system along y per frequency.
+    makeC(grid.x.points(), grid.y.points(), mat, *this, u);
+    for (double &value : u)
+    {
+        value = -value;
+    }
+    const SineTransform transform(nx);
+    auto transformX = [&]()
+    {
+        parallelFor(ny, [&](size_t kBegin, size_t kEnd)
+        {
+            std::vector<std::complex<double>> work;
+            for (size_t k = kBegin; k < kEnd; k++)
+            {
+                transform.apply(u.data() + k, ny, work);
+            }
+        });
+    };
+
+    transformX();
+    parallelFor(nx, [&](size_t mBegin, size_t mEnd)
+    {
+        std::vector<double> l, d, line(ny);
+        const std::vector<double> offDiagonal(ny, by);
+        for (size_t m = mBegin; m < mEnd; m++)
+        {
+            const double s = std::sin(M_PI * (m + 1) / (2.0 * (nx + 1)));
+            const double eigenvalue = -4 * bx * s * s;
+            triDecomp(offDiagonal, std::vector<double>(ny, eigenvalue - 2 * by), offDiagonal, l, d);
+            triSolve(l, d, offDiagonal, u.data() + m * ny, u.data() + m * ny);
+        }
+    });
+    transformX();
+
+    const double scale = 2.0 / (nx + 1);
+    for (double &value : u)
+    {
+        value = u0 + scale * value;
+    }
+}
+
+void Plate::solveSteady(const Grid& grid, StepSink& sink, const SolverOptions& options) const
+{
+    std::vector<double> u;
+    steadyState(grid, u, options);
+    sink.begin(1, grid.x.points(), grid.y.points());
+    sink.consume(0, grid.time.getLength(), ConstStepView(u.data(), grid.x.size(), grid.y.size()));
+    sink.end();
+}
+
+void Plate::solve(const Grid& grid, Solution& sol) const
+{
+    SolutionSink sink(sol);
+    solve(grid, sink);
+}
+
+void Plate::makeAdiOperator(size_t nx, size_t ny, double dx, double dy, double dt, AdiOperator& op) const
+{
+    ScopedPhase phase("factorize");
+    const Material &mat = Material::materials[material];
+    const double alpha = mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity());
+    const double bx = alpha / (dx * dx);
+    const double by = alpha / (dy * dy);
+    const double r = 2 / dt;
+
+    op.upperX.assign(nx, -bx);
+    triDecomp(std::vector<double>(nx, -bx), std::vector<double>(nx, r + 2 * bx), op.upperX, op.lx, op.ux);
+    op.upperY.assign(ny, -by);
+    triDecomp(std::vector<double>(ny, -by), std::vector<double>(ny, r + 2 * by), op.upperY, op.ly, op.uy);
+}
+
+/**
+ * @brief Solve the plate with a scheme of an iterative linear solver, on the whole 5-point system
+ * (see {@link iterativeStep}).
+ * 
+ * @tparam S Scheme, Euler or CrankNicolson.
+ * @param plate Plate.
+ * @param grid Grid.
+ * @param sink Sink of the steps.
+ * @param options Options of the solver.
+ * @param bx Diffusivity divided by dx^2.
+ * @param by Diffusivity divided by dy^2.
+ * @param C Source term.
+ * @return StepStats
+ */
+template <Scheme S>
+StepStats solveIterative(const Plate& plate, const Grid& grid, StepSink& sink, const SolverOptions& options, double bx, double by, const std::vector<double>& C)
+{
+    const size_t nx = grid.x.size();
+    const size_t ny = grid.y.size();
+    const double u0 = plate.getU0();
+    const double factor = S == Scheme::CrankNicolson ? 0.5 : 1;
+    std::vector<double> u(nx * ny, u0), half, rhs;
+    // One multigrid hierarchy per time step, the adaptive stepping only uses a few of them.
+    std::map<double, Multigrid> multigrids;
+    size_t iterations = 0;
+    const StepFunction step = [&](double dt, const std::vector<double>& cur, std::vector<double>& next)
+    {
+        auto it = multigrids.find(dt);
+        if (it == multigrids.end())
+        {
+            it = multigrids.emplace(dt, Multigrid(nx, ny, factor * bx, factor * by, 1 / dt, 2, 2, options.smoother)).first;
+        }
+        iterations += iterativeStep<S>(it->second, options, dt, u0, C, cur, rhs, half, next);
+    };
+
+    StepStats stats;
+    if (options.tolerance == 0)
+    {
+        stats = solveFixed(grid, u, step, sink, options.every);
+    }
+    else
+    {
+        stats = solveAdaptive(grid, options.tolerance, order(S), u, step, sink, options.every);
+    }
+    stats.iterations = iterations;
+    return stats;
+}
+
+/**
+ * @brief Solve the plate with a scheme, the operators of the implicit schemes being split by direction and
+ * taken from the factorization cache, unless an iterative linear solver is chosen. The scheme is a template
+ * parameter, so that the steps are dispatched once per solve.
+ * 
+ * @tparam S Scheme.
+ * @param plate Plate.
+ * @param grid Grid.
+ * @param sink Sink of the steps.
+ * @param options Options of the solver.
+ * @return StepStats
+ */
+template <Scheme S>
+StepStats solveScheme(const Plate& plate, const Grid& grid, StepSink& sink, const SolverOptions& options)
+{
+    const Material &mat = Material::materials[plate.getMaterial()];
+    const size_t nx = grid.x.size();
+    const size_t ny = grid.y.size();
+    const double bx = plate.diffusivity() / (grid.x.step() * grid.x.step());
+    const double by = plate.diffusivity() / (grid.y.step() * grid.y.step());
+
+    std::vector<double> C;
+    makeC(grid.x.points(), grid.y.points(), mat, plate, C);
+    if constexpr (S != Scheme::Explicit)
+    {
+        if (options.solver != LinearSolver::Direct)
+        {
+            return solveIterative<S>(plate, grid, sink, options, bx, by, C);
+        }
+    }
+
+    StepStats stats;
+    HeatSolver<2, S, double> solver({HeatAxis<double>{{nullptr, nullptr, nullptr, 0, nx}, bx}, HeatAxis<double>{{nullptr, nullptr, nullptr, 0, ny}, by}}, plate.getU0(), nullptr, C.data(), 1, options.tileDepth);
+    std::shared_ptr<const AdiOperator> op;
+    // The cache hands out the same operator for the same time step, so the solver is only rebound when dt changes.
+    auto useOperator = [&](double dt)
+    {
+        if constexpr (S != Scheme::Explicit)
+        {
+            std::shared_ptr<const AdiOperator> stepOp = FactorizationCache::global().plateOperator(plate, nx, ny, grid.x.step(), grid.y.step(), Plate::operatorStep(S, dt));
+            if (stepOp != op)
+            {
+                op = stepOp;
+                solver.setAxes(adiAxes(*op, bx, by));
+            }
+        }
+    };
+    if (options.tolerance == 0)
+    {
+        useOperator(grid.time.step());
+        solver.run(grid, sink, options.every);
+        stats.steps = grid.time.size() - 1;
+        return stats;
+    }
+
+    std::vector<double> u(nx * ny, plate.getU0()), half(nx * ny);
+    const StepFunction step = [&](double dt, const std::vector<double>& cur, std::vector<double>& next)
+    {
+        useOperator(dt);
+        next.resize(nx * ny);
+        solver.step(dt, cur.data(), half.data(), next.data());
+    };
+    return solveAdaptive(grid, options.tolerance, order(S), u, step, sink, options.every);
+}
+
+StepStats Plate::solve(const Grid& grid, StepSink& sink, const SolverOptions& options) const
+{
+    const Scheme scheme = options.scheme.value_or(defaultScheme);
+    if (scheme == Scheme::CrankNicolson)
+    {
+        return solveScheme<Scheme::CrankNicolson>(*this, grid, sink, options);
+    }
+    else if (scheme == Scheme::Explicit)
+    {
+        return solveScheme<Scheme::Explicit>(*this, grid, sink, options);
+    }
+    return solveScheme<Scheme::Euler>(*this, grid, sink, options);
+}
+
+void Plate::solve(const Grid& grid, const AdiOperator& op, StepSink& sink, size_t every, Scheme scheme) const
 {
+    const std::vector<double> &positionX = grid.x.points();
+    const std::vector<double> &positionY = grid.y.points();
+    const Material &mat = Material::materials[material];
+    const size_t nx = positionX.size();
+    const size_t ny = positionY.size();
+
+    const double dx = grid.x.step();
+    const double dy = grid.y.step();
+    const double alpha = mat.getThermalConductivity() / (mat.getDensity() * mat.getSpecificHeatCapacity());
+    const double bx = alpha / (dx * dx);
+    const double by = alpha / (dy * dy);
+
+    if (scheme == Scheme::Explicit)
+    {
+        throw Exn("The explicit scheme does not use an operator.");
+    }
+    if (op.ux.size() != nx || op.uy.size() != ny)
+    {
+        throw Exn("Operator does not match the grid.");
+    }
+
+    std::vector<double> C;
+    makeC(positionX, positionY, mat, *this, C);
 
-}
\ No newline at end of file
+    if (scheme == Scheme::CrankNicolson)
+    {
+        HeatSolver<2, Scheme::CrankNicolson, double>(adiAxes(op, bx, by), u0, nullptr, C.data()).run(grid, sink, every);
+    }
+    else
+    {
+        HeatSolver<2, Scheme::Euler, double>(adiAxes(op, bx, by), u0, nullptr, C.data()).run(grid, sink, every);
+    }
+}
@@ -0,0 +1,280 @@
+/**
+ * @file profile.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link profile.h}, and replaces the global operator new to count the allocations.
+ * @version 0.1
+ * @date 2023-01-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/profile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Not inlined, so that the compiler does not pair the malloc and free of the replacements with
+// the allocations of the standard containers of this file.
+[[gnu::noinline]] void* operator new(size_t size)
+{
+    Profiler::count(Counter::Allocations);
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+const char* counterName(Counter counter)
+{
+    switch (counter)
+    {
+    case Counter::Steps:
+        return "steps";
+    case Counter::Solves:
+        return "solves";
+    case Counter::BytesWritten:
+        return "bytes written";
+    case Counter::Allocations:
+        return "allocations";
+    }
+    return "";
+}
+
+/**
+ * @brief Open a hardware counter of the calling thread, inherited by the threads it starts.
+ *
+ * @param config Event (PERF_COUNT_HW_*).
+ * @return int File descriptor, -1 if the counter cannot be opened.
+ */
+int openHardwareCounter(uint64_t config)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+Profiler::~Profiler()
+{
+    for (const HardwareCounter &counter : hardware)
+    {
+        close(counter.fd);
+    }
+}
+
+Profiler& Profiler::global()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::enable()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active.load())
+    {
+        return;
+    }
+    const std::pair<const char*, uint64_t> events[] = {
+        {"cycles", PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_COUNT_HW_INSTRUCTIONS},
+        {"cache misses", PERF_COUNT_HW_CACHE_MISSES},
+        {"branch misses", PERF_COUNT_HW_BRANCH_MISSES}
+    };
+    for (const auto &event : events)
+    {
+        const int fd = openHardwareCounter(event.second);
+        if (fd >= 0)
+        {
+            hardware.push_back({event.first, fd});
+        }
+    }
+    start = std::chrono::steady_clock::now();
+    active.store(true);
+}
+
+Profiler::PhaseTable& Profiler::table()
+{
+    thread_local PhaseTable *local = nullptr;
+    if (!local)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tables.push_back(std::make_unique<PhaseTable>());
+        local = tables.back().get();
+    }
+    return *local;
+}
+
+void Profiler::addPhase(std::string_view name, double seconds)
+{
+    PhaseTable &phases = table();
+    auto it = phases.find(name);
+    if (it == phases.end())
+    {
+        it = phases.emplace(std::string(name), Phase()).first;
+    }
+    it->second.calls++;
+    it->second.seconds += seconds;
+}
+
+void Profiler::report(std::ostream& out, bool json)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    PhaseTable phases;
+    for (const std::unique_ptr<PhaseTable> &table : tables)
+    {
+        for (const auto &phase : *table)
+        {
+            Phase &total = phases[phase.first];
+            total.calls += phase.second.calls;
+            total.seconds += phase.second.seconds;
+        }
+    }
+    std::vector<std::pair<const char*, uint64_t>> hardwareValues;
+    for (const HardwareCounter &counter : hardware)
+    {
+        uint64_t value;
+        if (read(counter.fd, &value, sizeof(value)) == sizeof(value))
+        {
+            hardwareValues.push_back({counter.name, value});
+        }
+    }
+
+    char line[256];
+    if (json)
+    {
+        snprintf(line, sizeof(line), "{\n  \"wallSeconds\": %.6f,\n  \"phases\": [", wall);
+        out << line;
+        size_t i = 0;
+        for (const auto &phase : phases)
+        {
+            snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"calls\": %zu, \"seconds\": %.6f}", i++ > 0 ? "," : "", phase.first.c_str(), phase.second.calls, phase.second.seconds);
+            out << line;
+        }
+        out << "\n  ],\n  \"counters\": {";
+        for (size_t c = 0; c < counterCount; c++)
+        {
+            snprintf(line, sizeof(line), "%s\n    \"%s\": %llu", c > 0 ? "," : "", counterName(static_cast<Counter>(c)), static_cast<unsigned long long>(value(static_cast<Counter>(c))));
+            out << line;
+        }
+        out << "\n  },\n  \"hardware\": {";
+        for (size_t c = 0; c < hardwareValues.size(); c++)
+        {
+            snprintf(line, sizeof(line), "%s\n    \"%s\": %llu", c > 0 ? "," : "", hardwareValues[c].first, static_cast<unsigned long long>(hardwareValues[c].second));
+            out << line;
+        }
+        out << (hardwareValues.empty() ? "}\n}" : "\n  }\n}") << std::endl;
+        return;
+    }
+
+    snprintf(line, sizeof(line), "\nProfile (%.3f s)\n%-24s %10s %12s %7s\n", wall, "Phase", "Calls", "Time (s)", "Share");
+    out << line;
+    for (const auto &phase : phases)
+    {
+        snprintf(line, sizeof(line), "%-24s %10zu %12.6f %6.1f%%\n", phase.first.c_str(), phase.second.calls, phase.second.seconds, wall > 0 ? 100 * phase.second.seconds / wall : 0.0);
+        out << line;
+    }
+    for (size_t c = 0; c < counterCount; c++)
+    {
+        snprintf(line, sizeof(line), "%-24s %23llu\n", counterName(static_cast<Counter>(c)), static_cast<unsigned long long>(value(static_cast<Counter>(c))));
+        out << line;
+    }
+    if (hardware.empty())
+    {
+        out << "Hardware counters unavailable (perf_event_open is not permitted)." << std::endl;
+    }
+    for (const auto &counter : hardwareValues)
+    {
+        snprintf(line, sizeof(line), "%-24s %23llu\n", counter.first, static_cast<unsigned long long>(counter.second));
+        out << line;
+    }
+    out << std::flush;
+}
+
+TraceRecorder& TraceRecorder::global()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::enable(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    file.open(name);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Unable to open file " + name);
+    }
+    filename = name;
+    start = std::chrono::steady_clock::now();
+    active.store(true);
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::buffer()
+{
+    thread_local ThreadBuffer *local = nullptr;
+    if (!local)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        local = buffers.back().get();
+        local->thread = buffers.size();
+        local->events.reserve(4096);
+    }
+    return *local;
+}
+
+void TraceRecorder::record(const char* name, std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+    buffer().events.push_back({name, std::chrono::duration<double, std::micro>(begin - start).count(), std::chrono::duration<double, std::micro>(end - begin).count()});
+}
+
+void TraceRecorder::write()
+{
+    active.store(false);
+    std::lock_guard<std::mutex> lock(mutex);
+    char line[256];
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : buffers)
+    {
+        snprintf(line, sizeof(line), "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %zu, \"args\": {\"name\": \"thread %zu\"}}", first ? "" : ",", buffer->thread, buffer->thread);
+        file << line;
+        first = false;
+        for (const Event &event : buffer->events)
+        {
+            snprintf(line, sizeof(line), ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %zu, \"ts\": %.3f, \"dur\": %.3f}", event.name, buffer->thread, event.begin, event.duration);
+            file << line;
+        }
+    }
+    file << "\n]}" << std::endl;
+    file.close();
+    if (file.fail())
+    {
+        throw std::runtime_error("Unable to write file " + filename);
+    }
+}
@@ -11,6 +11,10 @@
 
 #include "../header/sdl.h"
 #include "../header/exn.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+#include <string>
 
 Sdl::Sdl(/* args */)
 {
@@ -21,12 +25,12 @@ Sdl::~Sdl()
 }
 
 /**
- * @brief Get the max of a double vector.
+ * @brief Get the max of a time step.
  * 
- * @param v Vector.
+ * @param v Time step.
  * @return double max.
  */
-double max(const std::vector<double> &v)
+double max(const ConstStepView &v)
 {
     double max = v[0];
     for (size_t i = 1; i < v.size(); i++)
@@ -39,7 +43,7 @@ double max(const std::vector<double> &v)
     return max;
 }
 
-void Sdl::SdlBarRunWindow(const Bar &bar, const std::vector<double> &time, const std::vector<double> &position, std::vector<std::vector<double>> &sol)
+void Sdl::SdlBarRunWindow(const Bar &bar, const std::vector<double> &time, const std::vector<double> &position, const Solution &sol)
 {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0)
     {
@@ -61,15 +65,18 @@ void Sdl::SdlBarRunWindow(const Bar &bar, const std::vector<double> &time, const
             }
             else if (!plot)
             {
+                // Only the drawing is timed, not the time the window stays open.
+                ScopedPhase phase("render");
                 for (size_t i = 0; i < time.size(); i += 10)
                 {
+                    ScopedPhase framePhase("frame");
                     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
                     SDL_RenderClear(renderer);
                     double maxItem = max(sol[i]);
                     for (size_t j = 0; j < position.size() - 1; j++)
                     {
                         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                        SDL_RenderDrawLine(renderer, position[j] * 1280 / bar.getL(), sol[i][j] * 720 / maxItem, position[j + 1] * 1280 / bar.getL(), sol[i][j + 1] * 720 / maxItem);
+                        SDL_RenderDrawLine(renderer, position[j] * 1280 / bar.getL(), sol(i, j) * 720 / maxItem, position[j + 1] * 1280 / bar.getL(), sol(i, j + 1) * 720 / maxItem);
                         SDL_RenderPresent(renderer);
                     }
                 }
@@ -82,10 +89,69 @@ void Sdl::SdlBarRunWindow(const Bar &bar, const std::vector<double> &time, const
     SDL_Quit();
 }
 
-void Sdl::SdlBarRunWindow(const Plate &plate, const std::vector<double> &time, const std::vector<double> &positionX, const std::vector<double> &positionY, std::vector<std::vector<std::vector<double>>> &sol)
+void Sdl::SdlBarRunWindow(const Plate &plate, const std::vector<double> &time, const std::vector<double> &positionX, const std::vector<double> &positionY, const Solution &sol)
 {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0)
     {
         throw Exn((std::string("SDL_Init Error: ") + SDL_GetError()).c_str());
     }
-}
\ No newline at end of file
+    SDL_Window *window = SDL_CreateWindow("Heat equation solution for a plate", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 720, 720, SDL_WINDOW_SHOWN);
+    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    const int nx = static_cast<int>(positionX.size());
+    const int ny = static_cast<int>(positionY.size());
+    SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, nx, ny);
+
+    // Colors go from blue (u0) to red (hottest point of the whole simulation).
+    const double minItem = plate.getU0();
+    double maxItem = minItem;
+    for (size_t i = 0; i < time.size(); i++)
+    {
+        maxItem = std::max(maxItem, max(sol[i]));
+    }
+    const double range = maxItem > minItem ? maxItem - minItem : 1.0;
+
+    std::vector<Uint32> pixels(positionX.size() * positionY.size());
+    SDL_Event event;
+    bool quit = false;
+    bool plot = false;
+    while (!quit)
+    {
+        while (SDL_PollEvent(&event))
+        {
+            if (event.type == SDL_QUIT)
+            {
+                quit = true;
+                break;
+            }
+            else if (!plot)
+            {
+                // Only the drawing is timed, not the time the window stays open.
+                ScopedPhase phase("render");
+                for (size_t i = 0; i < time.size(); i += 10)
+                {
+                    ScopedPhase framePhase("frame");
+                    const ConstStepView step = sol[i];
+                    // Texture rows go along y, from the top of the window.
+                    for (int k = 0; k < ny; k++)
+                    {
+                        for (int j = 0; j < nx; j++)
+                        {
+                            const double ratio = std::clamp((step(j, k) - minItem) / range, 0.0, 1.0);
+                            const Uint32 red = static_cast<Uint32>(255 * ratio);
+                            pixels[(ny - 1 - k) * nx + j] = 0xFF000000u | (red << 16) | (255 - red);
+                        }
+                    }
+                    SDL_UpdateTexture(texture, nullptr, pixels.data(), nx * sizeof(Uint32));
+                    SDL_RenderClear(renderer);
+                    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+                    SDL_RenderPresent(renderer);
+                }
+                plot = true;
+            }
+        }
+    }
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file sink.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link sink.h}.
+ * @version 0.1
+ * @date 2023-01-04
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/sink.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+
+size_t streamedSteps(size_t nt, size_t every)
+{
+    if (nt == 0)
+    {
+        return 0;
+    }
+    return (nt - 1) / every + 1 + ((nt - 1) % every != 0 ? 1 : 0);
+}
+
+StepSink::~StepSink()
+{
+}
+
+void StepSink::begin(size_t, const std::vector<double>&, const std::vector<double>&)
+{
+}
+
+void StepSink::end()
+{
+}
+
+SolutionSink::SolutionSink(Solution& sol) : sol(sol)
+{
+}
+
+void SolutionSink::begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY)
+{
+    sol.resize(steps, positionX.size(), positionY.empty() ? 1 : positionY.size());
+    time.clear();
+    time.reserve(steps);
+}
+
+void SolutionSink::consume(size_t, double t, ConstStepView step)
+{
+    std::copy(step.begin(), step.end(), sol[time.size()].begin());
+    time.push_back(t);
+}
+
+CsvSink::CsvSink(std::ostream& out, const std::string& separator, const std::string& prefix, int precision, size_t threads) : writer(out, precision, threads), separator(separator), prefix(prefix)
+{
+}
+
+void CsvSink::begin(size_t, const std::vector<double>& positionX, const std::vector<double>& positionY)
+{
+    if (positionY.empty())
+    {
+        writer.write(prefix);
+    }
+    writer.writeRow(positionX.data(), positionX.size(), separator);
+    writer.write('\n');
+    if (!positionY.empty())
+    {
+        writer.writeRow(positionY.data(), positionY.size(), separator);
+        writer.write('\n');
+    }
+}
+
+void CsvSink::consume(size_t, double t, ConstStepView step)
+{
+    ScopedPhase phase("output/csv");
+    writer.write(t);
+    writer.write(separator);
+    writer.writeRow(step.data(), step.size(), separator);
+    writer.write('\n');
+}
+
+void CsvSink::end()
+{
+    ScopedPhase phase("output/csv");
+    writer.flush();
+}
+
+void TeeSink::begin(size_t steps, const std::vector<double>& positionX, const std::vector<double>& positionY)
+{
+    for (StepSink *sink : sinks)
+    {
+        sink->begin(steps, positionX, positionY);
+    }
+}
+
+void TeeSink::consume(size_t i, double t, ConstStepView step)
+{
+    for (StepSink *sink : sinks)
+    {
+        sink->consume(i, t, step);
+    }
+}
+
+void TeeSink::end()
+{
+    for (StepSink *sink : sinks)
+    {
+        sink->end();
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * @file solution.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link solution.h}.
+ * @version 0.1
+ * @date 2023-01-03
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/solution.h"
+
+#include <new>
+
+Solution::Solution(size_t nt, size_t nx, size_t ny) : nt(0), nx(0), ny(0)
+{
+    resize(nt, nx, ny);
+}
+
+void Solution::resize(size_t nt, size_t nx, size_t ny)
+{
+    const size_t count = nt * nx * ny;
+    if (count != this->nt * this->nx * this->ny)
+    {
+        values.reset();
+        if (count > 0)
+        {
+            // aligned_alloc requires a size which is a multiple of the alignment.
+            const size_t bytes = (count * sizeof(double) + alignment - 1) / alignment * alignment;
+            values.reset(static_cast<double *>(std::aligned_alloc(alignment, bytes)));
+            if (!values)
+            {
+                throw std::bad_alloc();
+            }
+        }
+    }
+    this->nt = nt;
+    this->nx = nx;
+    this->ny = ny;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file stencil.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link stencil.h}.
+ * @version 0.1
+ * @date 2023-01-14
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/stencil.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STENCIL_X86
+#endif
+
+/**
+ * @brief 3-point kernel on a line.
+ *
+ */
+using Stencil3Kernel = void (*)(const double*, double*, size_t, double, double, double, double);
+
+/**
+ * @brief 5-point kernel on an inner row: the rows on both sides are in the grid.
+ *
+ */
+using Row5Kernel = void (*)(const double*, const double*, const double*, double*, size_t, double, double, double, double);
+
+/**
+ * @brief Kernels of an instruction set.
+ *
+ */
+struct StencilKernels
+{
+    const char* isa;
+    Stencil3Kernel line;
+    Row5Kernel row;
+    /**
+     * @brief Kernel of the first and last rows, which have a side outside of the grid.
+     *
+     */
+    Row5Kernel border;
+};
+
+/**
+ * @brief Value of the 3-point stencil at a point, a u + b (sum of the neighbours), with the fused multiply-add
+ * of the vector kernels, so that every instruction set gives the same results.
+ *
+ * @param a Coefficient of the center.
+ * @param center Value of the point.
+ * @param b Coefficient of the neighbours.
+ * @param sides Sum of the neighbours.
+ * @return double
+ */
+inline double point3(double a, double center, double b, double sides)
+{
+    return std::fma(a, center, b * sides);
+}
+
+/**
+ * @brief Value of the 5-point stencil at a point, a u + bx (west + east) + by (south + north), with the fused
+ * multiply-adds of the vector kernels.
+ *
+ * @param a Coefficient of the center.
+ * @param center Value of the point.
+ * @param bx Coefficient of the neighbours along x.
+ * @param across Sum of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param along Sum of the neighbours along y.
+ * @return double
+ */
+inline double point5(double a, double center, double bx, double across, double by, double along)
+{
+    return std::fma(a, center, std::fma(bx, across, by * along));
+}
+
+/**
+ * @brief 3-point kernel on a line, in plain C++ (see {@link stencil3}).
+ *
+ */
+void stencil3Generic(const double* u, double* y, size_t n, double a, double b, double left, double right)
+{
+    if (n == 1)
+    {
+        y[0] = point3(a, u[0], b, left + right);
+        return;
+    }
+    y[0] = point3(a, u[0], b, left + u[1]);
+    for (size_t i = 1; i < n - 1; i++)
+    {
+        y[i] = point3(a, u[i], b, u[i - 1] + u[i + 1]);
+    }
+    y[n - 1] = point3(a, u[n - 1], b, u[n - 2] + right);
+}
+
+/**
+ * @brief 5-point kernel on a row, the rows on its sides being null when they are outside of the grid.
+ * Always inlined, so that the kernels of the border rows of an instruction set use its FMA instructions.
+ *
+ * @param w Row on the west, or nullptr.
+ * @param c Row.
+ * @param e Row on the east, or nullptr.
+ * @param y Result.
+ * @param ny Number of points of a row.
+ * @param a Coefficient of the center.
+ * @param bx Coefficient of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param ghost Value outside of the grid.
+ */
+__attribute__((always_inline)) inline void row5Generic(const double* w, const double* c, const double* e, double* y, size_t ny, double a, double bx, double by, double ghost)
+{
+    for (size_t k = 0; k < ny; k++)
+    {
+        const double west = w ? w[k] : ghost;
+        const double east = e ? e[k] : ghost;
+        const double south = k > 0 ? c[k - 1] : ghost;
+        const double north = k < ny - 1 ? c[k + 1] : ghost;
+        y[k] = point5(a, c[k], bx, west + east, by, south + north);
+    }
+}
+
+#ifdef STENCIL_X86
+/**
+ * @brief 3-point kernel on a line, with AVX2.
+ *
+ */
+__attribute__((target("avx2,fma")))
+void stencil3Avx2(const double* u, double* y, size_t n, double a, double b, double left, double right)
+{
+    if (n < 2)
+    {
+        stencil3Generic(u, y, n, a, b, left, right);
+        return;
+    }
+    const __m256d va = _mm256_set1_pd(a);
+    const __m256d vb = _mm256_set1_pd(b);
+    y[0] = point3(a, u[0], b, left + u[1]);
+    size_t i = 1;
+    for (; i + 4 < n; i += 4)
+    {
+        const __m256d sides = _mm256_add_pd(_mm256_loadu_pd(u + i - 1), _mm256_loadu_pd(u + i + 1));
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(u + i), _mm256_mul_pd(vb, sides)));
+    }
+    for (; i < n - 1; i++)
+    {
+        y[i] = point3(a, u[i], b, u[i - 1] + u[i + 1]);
+    }
+    y[n - 1] = point3(a, u[n - 1], b, u[n - 2] + right);
+}
+
+/**
+ * @brief 5-point kernel on an inner row, with AVX2.
+ *
+ */
+__attribute__((target("avx2,fma")))
+void row5Avx2(const double* w, const double* c, const double* e, double* y, size_t ny, double a, double bx, double by, double ghost)
+{
+    if (ny < 2)
+    {
+        row5Generic(w, c, e, y, ny, a, bx, by, ghost);
+        return;
+    }
+    const __m256d va = _mm256_set1_pd(a);
+    const __m256d vbx = _mm256_set1_pd(bx);
+    const __m256d vby = _mm256_set1_pd(by);
+    y[0] = point5(a, c[0], bx, w[0] + e[0], by, ghost + c[1]);
+    size_t k = 1;
+    for (; k + 4 < ny; k += 4)
+    {
+        const __m256d across = _mm256_add_pd(_mm256_loadu_pd(w + k), _mm256_loadu_pd(e + k));
+        const __m256d along = _mm256_add_pd(_mm256_loadu_pd(c + k - 1), _mm256_loadu_pd(c + k + 1));
+        const __m256d value = _mm256_fmadd_pd(va, _mm256_loadu_pd(c + k), _mm256_fmadd_pd(vbx, across, _mm256_mul_pd(vby, along)));
+        _mm256_storeu_pd(y + k, value);
+    }
+    for (; k < ny - 1; k++)
+    {
+        y[k] = point5(a, c[k], bx, w[k] + e[k], by, c[k - 1] + c[k + 1]);
+    }
+    y[ny - 1] = point5(a, c[ny - 1], bx, w[ny - 1] + e[ny - 1], by, c[ny - 2] + ghost);
+}
+
+/**
+ * @brief 5-point kernel on a border row, with AVX2.
+ *
+ */
+__attribute__((target("avx2,fma")))
+void row5BorderAvx2(const double* w, const double* c, const double* e, double* y, size_t ny, double a, double bx, double by, double ghost)
+{
+    row5Generic(w, c, e, y, ny, a, bx, by, ghost);
+}
+
+/**
+ * @brief 3-point kernel on a line, with AVX-512.
+ *
+ */
+__attribute__((target("avx512f")))
+void stencil3Avx512(const double* u, double* y, size_t n, double a, double b, double left, double right)
+{
+    if (n < 2)
+    {
+        stencil3Generic(u, y, n, a, b, left, right);
+        return;
+    }
+    const __m512d va = _mm512_set1_pd(a);
+    const __m512d vb = _mm512_set1_pd(b);
+    y[0] = point3(a, u[0], b, left + u[1]);
+    size_t i = 1;
+    for (; i + 8 < n; i += 8)
+    {
+        const __m512d sides = _mm512_add_pd(_mm512_loadu_pd(u + i - 1), _mm512_loadu_pd(u + i + 1));
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(u + i), _mm512_mul_pd(vb, sides)));
+    }
+    for (; i < n - 1; i++)
+    {
+        y[i] = point3(a, u[i], b, u[i - 1] + u[i + 1]);
+    }
+    y[n - 1] = point3(a, u[n - 1], b, u[n - 2] + right);
+}
+
+/**
+ * @brief 5-point kernel on an inner row, with AVX-512.
+ *
+ */
+__attribute__((target("avx512f")))
+void row5Avx512(const double* w, const double* c, const double* e, double* y, size_t ny, double a, double bx, double by, double ghost)
+{
+    if (ny < 2)
+    {
+        row5Generic(w, c, e, y, ny, a, bx, by, ghost);
+        return;
+    }
+    const __m512d va = _mm512_set1_pd(a);
+    const __m512d vbx = _mm512_set1_pd(bx);
+    const __m512d vby = _mm512_set1_pd(by);
+    y[0] = point5(a, c[0], bx, w[0] + e[0], by, ghost + c[1]);
+    size_t k = 1;
+    for (; k + 8 < ny; k += 8)
+    {
+        const __m512d across = _mm512_add_pd(_mm512_loadu_pd(w + k), _mm512_loadu_pd(e + k));
+        const __m512d along = _mm512_add_pd(_mm512_loadu_pd(c + k - 1), _mm512_loadu_pd(c + k + 1));
+        const __m512d value = _mm512_fmadd_pd(va, _mm512_loadu_pd(c + k), _mm512_fmadd_pd(vbx, across, _mm512_mul_pd(vby, along)));
+        _mm512_storeu_pd(y + k, value);
+    }
+    for (; k < ny - 1; k++)
+    {
+        y[k] = point5(a, c[k], bx, w[k] + e[k], by, c[k - 1] + c[k + 1]);
+    }
+    y[ny - 1] = point5(a, c[ny - 1], bx, w[ny - 1] + e[ny - 1], by, c[ny - 2] + ghost);
+}
+
+/**
+ * @brief 5-point kernel on a border row, with AVX-512.
+ *
+ */
+__attribute__((target("avx512f")))
+void row5BorderAvx512(const double* w, const double* c, const double* e, double* y, size_t ny, double a, double bx, double by, double ghost)
+{
+    row5Generic(w, c, e, y, ny, a, bx, by, ghost);
+}
+#endif
+
+/**
+ * @brief Choose the kernels of the widest instruction set supported by the processor.
+ *
+ * @return StencilKernels
+ */
+StencilKernels selectKernels()
+{
+#ifdef STENCIL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return {"avx512", stencil3Avx512, row5Avx512, row5BorderAvx512};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return {"avx2", stencil3Avx2, row5Avx2, row5BorderAvx2};
+    }
+#endif
+    return {"generic", stencil3Generic, row5Generic, row5Generic};
+}
+
+/**
+ * @brief Get the kernels of the processor, chosen on the first call.
+ *
+ * @return const StencilKernels&
+ */
+const StencilKernels& kernels()
+{
+    static const StencilKernels selected = selectKernels();
+    return selected;
+}
+
+void stencil3(const double* u, double* y, size_t n, double a, double b, double left, double right)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    kernels().line(u, y, n, a, b, left, right);
+}
+
+void stencil5(const double* u, double* y, size_t nx, size_t ny, double a, double bx, double by, double ghost, size_t jBegin, size_t jEnd)
+{
+    const Row5Kernel row = kernels().row;
+    const Row5Kernel border = kernels().border;
+    for (size_t j = jBegin; j < jEnd; j++)
+    {
+        const double *center = u + j * ny;
+        const double *west = j > 0 ? center - ny : nullptr;
+        const double *east = j < nx - 1 ? center + ny : nullptr;
+        if (west && east)
+        {
+            row(west, center, east, y + j * ny, ny, a, bx, by, ghost);
+        }
+        else
+        {
+            border(west, center, east, y + j * ny, ny, a, bx, by, ghost);
+        }
+    }
+}
+
+const char* stencilIsa()
+{
+    return kernels().isa;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file stepping.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link stepping.h}.
+ * @version 0.1
+ * @date 2023-01-11
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/stepping.h"
+#include "../header/exn.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+Scheme parseScheme(const std::string& name)
+{
+    if (name == "euler")
+    {
+        return Scheme::Euler;
+    }
+    if (name == "cn" || name == "crank-nicolson")
+    {
+        return Scheme::CrankNicolson;
+    }
+    if (name == "ftcs" || name == "explicit")
+    {
+        return Scheme::Explicit;
+    }
+    throw Exn("Unknown scheme, expected euler, cn or ftcs.");
+}
+
+size_t explicitSubSteps(double dt, double stableStep)
+{
+    return std::max<size_t>(1, static_cast<size_t>(std::ceil(dt / stableStep)));
+}
+
+LinearSolver parseLinearSolver(const std::string& name)
+{
+    if (name == "direct")
+    {
+        return LinearSolver::Direct;
+    }
+    if (name == "mg" || name == "multigrid")
+    {
+        return LinearSolver::Multigrid;
+    }
+    if (name == "pcg" || name == "cg")
+    {
+        return LinearSolver::ConjugateGradient;
+    }
+    throw Exn("Unknown linear solver, expected direct, mg or pcg.");
+}
+
+StepStats solveFixed(const Grid& grid, std::vector<double>& u, const StepFunction& step, StepSink& sink, size_t every)
+{
+    const std::vector<double> &time = grid.time.points();
+    const size_t nt = time.size();
+    const size_t sizeX = grid.x.size();
+    const size_t sizeY = grid.y.empty() ? 1 : grid.y.size();
+
+    const double dt = grid.time.step();
+
+    ScopedPhase phase("time loop");
+    StepStats stats;
+    sink.begin(streamedSteps(nt, every), grid.x.points(), grid.y.points());
+    sink.consume(0, time[0], ConstStepView(u.data(), sizeX, sizeY));
+    for (size_t i = 0; i < nt - 1; i++)
+    {
+        ScopedPhase stepPhase("step");
+        step(dt, u, u);
+        stats.steps++;
+        if (isStreamed(i + 1, nt, every))
+        {
+            sink.consume(i + 1, time[i + 1], ConstStepView(u.data(), sizeX, sizeY));
+        }
+    }
+    sink.end();
+    Profiler::count(Counter::Steps, stats.steps);
+    return stats;
+}
+
+StepStats solveAdaptive(const Grid& grid, double tolerance, unsigned order, std::vector<double>& u, const StepFunction& step, StepSink& sink, size_t every)
+{
+    if (!(tolerance > 0))
+    {
+        throw Exn("The tolerance must be positive.");
+    }
+    const std::vector<double> &time = grid.time.points();
+    const size_t nt = time.size();
+    const size_t n = u.size();
+    const size_t sizeX = grid.x.size();
+    const size_t sizeY = grid.y.empty() ? 1 : grid.y.size();
+
+    // Times are counted in ticks of base * 2^minLevel, so that the grid times are reached exactly.
+    const int minLevel = -20;
+    const double base = grid.time.step();
+    const uint64_t end = static_cast<uint64_t>(nt - 1) << -minLevel;
+    int maxLevel = 0;
+    while ((uint64_t(1) << (maxLevel + 1 - minLevel)) <= end && maxLevel < 20)
+    {
+        maxLevel++;
+    }
+    // Doubling the step multiplies the local error by 2^(order + 1).
+    const double growth = std::ldexp(1.0, order + 1);
+    const double richardson = std::ldexp(1.0, order) - 1;
+
+    ScopedPhase phase("time loop");
+    StepStats stats;
+    std::vector<double> coarse(n), fine(n), previous(n), interpolated(n);
+    uint64_t ticks = 0;
+    size_t nextOutput = 1;
+    int level = 0;
+
+    sink.begin(streamedSteps(nt, every), grid.x.points(), grid.y.points());
+    sink.consume(0, time[0], ConstStepView(u.data(), sizeX, sizeY));
+    while (ticks < end)
+    {
+        ScopedPhase stepPhase("step");
+        while (ticks + (uint64_t(1) << (level - minLevel)) > end)
+        {
+            level--;
+        }
+        const uint64_t stepTicks = uint64_t(1) << (level - minLevel);
+        const double dt = std::ldexp(base, level);
+
+        step(dt, u, coarse);
+        step(dt / 2, u, fine);
+        step(dt / 2, fine, fine);
+
+        double error = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            error = std::max(error, std::abs(fine[i] - coarse[i]) / (richardson * tolerance * std::max(1.0, std::abs(fine[i]))));
+        }
+        if (!(error <= 1) && level > minLevel)
+        {
+            level--;
+            stats.rejected++;
+            continue;
+        }
+
+        stats.steps++;
+        previous.swap(u);
+        u.swap(fine);
+        const uint64_t start = ticks;
+        ticks += stepTicks;
+        for (; nextOutput < nt && (static_cast<uint64_t>(nextOutput) << -minLevel) <= ticks; nextOutput++)
+        {
+            if (!isStreamed(nextOutput, nt, every))
+            {
+                continue;
+            }
+            const double theta = static_cast<double>((static_cast<uint64_t>(nextOutput) << -minLevel) - start) / stepTicks;
+            for (size_t i = 0; i < n; i++)
+            {
+                interpolated[i] = previous[i] + theta * (u[i] - previous[i]);
+            }
+            sink.consume(nextOutput, time[nextOutput], ConstStepView(interpolated.data(), sizeX, sizeY));
+        }
+        if (error * growth < 1 && level < maxLevel)
+        {
+            level++;
+        }
+    }
+    sink.end();
+    Profiler::count(Counter::Steps, stats.steps);
+    return stats;
+}
@@ -0,0 +1,294 @@
+/**
+ * @file sweep.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link sweep.h}.
+ * @version 0.1
+ * @date 2023-01-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/sweep.h"
+#include "../header/binary.h"
+#include "../header/cache.h"
+#include "../header/sink.h"
+#include "../header/threadpool.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+std::vector<Scenario> readJobFile(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Unable to open file " + filename);
+    }
+    std::vector<Scenario> scenarios;
+    std::string line;
+    size_t number = 0;
+    while (std::getline(file, line))
+    {
+        number++;
+        std::istringstream in(line);
+        std::string kind;
+        if (!(in >> kind) || kind[0] == '#')
+        {
+            continue;
+        }
+        Scenario scenario;
+        if (kind != "bar" && kind != "plate")
+        {
+            throw std::runtime_error(filename + ":" + std::to_string(number) + ": expected bar or plate.");
+        }
+        scenario.plate = kind == "plate";
+        if (!(in >> scenario.material >> scenario.u0 >> scenario.tMax >> scenario.f >> scenario.L) || scenario.u0 < 0 || scenario.tMax <= 0 || scenario.L <= 0)
+        {
+            throw std::runtime_error(filename + ":" + std::to_string(number) + ": expected <material> <u0> <tMax> <f> <L> [output].");
+        }
+        if (!(in >> scenario.output))
+        {
+            scenario.output = "scenario-" + std::to_string(number) + ".bin";
+        }
+        scenarios.push_back(scenario);
+    }
+    return scenarios;
+}
+
+/**
+ * @brief Open the output of a scenario.
+ *
+ * @param scenario Scenario.
+ * @param grid Grid shared with the other scenarios of the group.
+ * @param options Options of the run.
+ * @param file Stream of a CSV output. It must outlive the sink, which flushes into it when destroyed.
+ * @return std::unique_ptr<StepSink>
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+std::unique_ptr<StepSink> openOutput(const Scenario &scenario, const Grid &grid, const RunOptions &options, std::ofstream &file)
+{
+    const std::string &out = scenario.output;
+    if (out.size() >= 4 && out.compare(out.size() - 4, 4, ".csv") == 0)
+    {
+        file.open(out);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Unable to open file " + out);
+        }
+        return std::make_unique<CsvSink>(file, ",", scenario.plate ? "" : "Time/position,", options.precision);
+    }
+    return std::make_unique<BinaryWriter>(out, BinaryInfo{scenario.u0, scenario.f, scenario.L, scenario.tMax, grid.time.step(), scenario.material}, options.singlePrecision);
+}
+
+/**
+ * @brief Solve a scenario and write its output.
+ *
+ * @tparam Model Bar or Plate.
+ * @param model Model.
+ * @param scenario Scenario.
+ * @param grid Grid shared with the other scenarios of the group.
+ * @param options Options of the run.
+ */
+template <typename Model>
+void solveScenario(const Model &model, const Scenario &scenario, const Grid &grid, const RunOptions &options)
+{
+    std::ofstream file;
+    const std::unique_ptr<StepSink> sink = openOutput(scenario, grid, options, file);
+    if (options.steady)
+    {
+        model.solveSteady(grid, *sink, makeSolverOptions(options));
+    }
+    else
+    {
+        model.solve(grid, *sink, makeSolverOptions(options));
+    }
+}
+
+/**
+ * @brief Solve bar scenarios sharing their material and grid together (see {@link Bar::solveBatch}),
+ * and write their outputs.
+ *
+ * @param scenarios Scenarios.
+ * @param grid Grid shared by the scenarios.
+ * @param options Options of the run.
+ * @param report Called with each scenario and its error, empty if it was solved.
+ */
+void solveBarBatch(const std::vector<const Scenario *> &scenarios, const Grid &grid, const RunOptions &options, const std::function<void(const Scenario &, const std::string &)> &report)
+{
+    std::vector<Bar> bars;
+    std::vector<const Scenario *> solved;
+    std::vector<std::ofstream> files(scenarios.size());
+    std::vector<std::unique_ptr<StepSink>> outputs;
+    std::vector<StepSink *> sinks;
+    for (size_t c = 0; c < scenarios.size(); c++)
+    {
+        const Scenario &scenario = *scenarios[c];
+        try
+        {
+            bars.push_back(Bar(scenario.u0, scenario.L, scenario.tMax, scenario.f, scenario.material));
+            outputs.push_back(openOutput(scenario, grid, options, files[c]));
+        }
+        catch (const std::exception &e)
+        {
+            if (bars.size() > outputs.size())
+            {
+                bars.pop_back();
+            }
+            report(scenario, e.what());
+            continue;
+        }
+        sinks.push_back(outputs.back().get());
+        solved.push_back(&scenario);
+    }
+    try
+    {
+        Bar::solveBatch(bars, grid, sinks, makeSolverOptions(options));
+        // The outputs are complete once their sinks are destroyed.
+        outputs.clear();
+    }
+    catch (const std::exception &e)
+    {
+        for (const Scenario *scenario : solved)
+        {
+            report(*scenario, e.what());
+        }
+        return;
+    }
+    for (const Scenario *scenario : solved)
+    {
+        report(*scenario, "");
+    }
+}
+
+/**
+ * @brief Maximum number of bars solved together by a task of the sweep.
+ *
+ */
+constexpr size_t batchWidth = 16;
+
+size_t runSweep(const std::vector<Scenario>& scenarios, const RunOptions& options)
+{
+    // Scenarios sharing the model, the material and the grid share their operator.
+    std::map<std::tuple<bool, std::string, double, double>, std::vector<size_t>> groups;
+    for (size_t i = 0; i < scenarios.size(); i++)
+    {
+        const Scenario &s = scenarios[i];
+        groups[std::make_tuple(s.plate, s.material, s.tMax, s.L)].push_back(i);
+    }
+
+    ThreadPool pool(options.jobs);
+    std::mutex outputMutex;
+    size_t failed = 0;
+    auto report = [&](const Scenario &scenario, const std::string &error)
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (error.empty())
+        {
+            std::cout << "Solution saved in " << scenario.output << std::endl;
+        }
+        else
+        {
+            failed++;
+            std::cerr << scenario.output << ": " << error << std::endl;
+        }
+    };
+
+    std::cout << "Solving " << scenarios.size() << " scenarios (" << groups.size() << " operators) on " << pool.size() << " threads..." << std::endl;
+    for (const auto &group : groups)
+    {
+        const std::vector<size_t> &members = group.second;
+        // The first task of a group builds the grid and warms the operator cache, then submits the scenarios
+        // to its own queue, from which idle workers steal them.
+        pool.submit([&, members]()
+        {
+            const Scenario &first = scenarios[members[0]];
+            std::shared_ptr<const Grid> grid;
+            try
+            {
+                const SolverOptions solverOptions = makeSolverOptions(options);
+                if (first.plate)
+                {
+                    const Plate plate(first.u0, first.L, first.tMax, first.f, first.material);
+                    grid = std::make_shared<const Grid>(makeGrid(plate, options));
+                    const Scheme scheme = solverOptions.scheme.value_or(Plate::defaultScheme);
+                    if (solverOptions.tolerance == 0 && solverOptions.solver == LinearSolver::Direct && scheme != Scheme::Explicit && !options.steady)
+                    {
+                        FactorizationCache::global().plateOperator(plate, grid->x.size(), grid->y.size(), grid->x.step(), grid->y.step(), Plate::operatorStep(scheme, grid->time.step()));
+                    }
+                }
+                else
+                {
+                    const Bar bar(first.u0, first.L, first.tMax, first.f, first.material);
+                    grid = std::make_shared<const Grid>(makeGrid(bar, options));
+                    const Scheme scheme = solverOptions.scheme.value_or(Bar::defaultScheme);
+                    if (solverOptions.tolerance == 0 && scheme != Scheme::Explicit && !options.steady)
+                    {
+                        FactorizationCache::global().barOperator(bar, grid->x.size(), grid->x.step(), Bar::operatorStep(scheme, grid->time.step()));
+                    }
+                }
+            }
+            catch (const std::exception &e)
+            {
+                for (size_t i : members)
+                {
+                    report(scenarios[i], e.what());
+                }
+                return;
+            }
+            if (!first.plate && options.tolerance == 0 && options.scheme != Scheme::Explicit && !options.steady)
+            {
+                // Bars sharing the operator are advanced together, in batches of up to batchWidth lanes,
+                // but the group is still spread over the workers.
+                const size_t width = std::min(batchWidth, (members.size() + pool.size() - 1) / pool.size());
+                for (size_t begin = 0; begin < members.size(); begin += width)
+                {
+                    std::vector<const Scenario *> batch;
+                    for (size_t i = begin; i < std::min(begin + width, members.size()); i++)
+                    {
+                        batch.push_back(&scenarios[members[i]]);
+                    }
+                    pool.submit([&, batch, grid]()
+                    {
+                        solveBarBatch(batch, *grid, options, report);
+                    });
+                }
+                return;
+            }
+            for (size_t i : members)
+            {
+                pool.submit([&, i, grid]()
+                {
+                    const Scenario &scenario = scenarios[i];
+                    try
+                    {
+                        if (scenario.plate)
+                        {
+                            solveScenario(Plate(scenario.u0, scenario.L, scenario.tMax, scenario.f, scenario.material), scenario, *grid, options);
+                        }
+                        else
+                        {
+                            solveScenario(Bar(scenario.u0, scenario.L, scenario.tMax, scenario.f, scenario.material), scenario, *grid, options);
+                        }
+                        report(scenario, "");
+                    }
+                    catch (const std::exception &e)
+                    {
+                        report(scenario, e.what());
+                    }
+                });
+            }
+        });
+    }
+    pool.wait();
+    std::cout << scenarios.size() - failed << " scenarios solved, " << failed << " failed (" << FactorizationCache::global().misses() << " operators built, " << FactorizationCache::global().hits() << " reused)." << std::endl;
+    return failed;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file textwriter.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link textwriter.h}.
+ * @version 0.1
+ * @date 2023-01-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/textwriter.h"
+#include "../header/profile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+/**
+ * @brief Format a double.
+ *
+ * @param first Start of the output.
+ * @param last End of the output.
+ * @param value Value.
+ * @param precision Number of significant digits, 0 for the shortest round-trip representation.
+ * @return char* End of the written characters.
+ */
+char *formatDouble(char *first, char *last, double value, int precision)
+{
+    if (precision > 0)
+    {
+        return std::to_chars(first, last, value, std::chars_format::general, precision).ptr;
+    }
+    return std::to_chars(first, last, value).ptr;
+}
+
+TextWriter::TextWriter(std::ostream& out, int precision, size_t threads, size_t bufferSize) : out(out), precision(std::min(precision, 17)), threads(std::max<size_t>(1, threads)), buffer(std::max(bufferSize, 4 * maxDoubleSize)), used(0)
+{
+    if (this->threads > 1)
+    {
+        pool = std::make_unique<ParallelPool>(this->threads);
+    }
+}
+
+TextWriter::~TextWriter()
+{
+    flush();
+}
+
+void TextWriter::emit(const char* data, size_t size)
+{
+    out.write(data, size);
+    Profiler::count(Counter::BytesWritten, size);
+}
+
+void TextWriter::write(double value)
+{
+    if (buffer.size() - used < maxDoubleSize)
+    {
+        emit(buffer.data(), used);
+        used = 0;
+    }
+    used = formatDouble(buffer.data() + used, buffer.data() + buffer.size(), value, precision) - buffer.data();
+}
+
+void TextWriter::write(const std::string& s)
+{
+    if (buffer.size() - used < s.size())
+    {
+        emit(buffer.data(), used);
+        used = 0;
+        if (s.size() > buffer.size())
+        {
+            emit(s.data(), s.size());
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, s.data(), s.size());
+    used += s.size();
+}
+
+void TextWriter::write(char c)
+{
+    if (used == buffer.size())
+    {
+        emit(buffer.data(), used);
+        used = 0;
+    }
+    buffer[used++] = c;
+}
+
+void TextWriter::format(const double* values, size_t n, const std::string& separator, std::vector<char>& chunk) const
+{
+    const size_t start = chunk.size();
+    chunk.resize(start + n * (maxDoubleSize + separator.size()));
+    char *p = chunk.data() + start;
+    char *last = chunk.data() + chunk.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        p = formatDouble(p, last, values[i], precision);
+        std::memcpy(p, separator.data(), separator.size());
+        p += separator.size();
+    }
+    chunk.resize(p - chunk.data());
+}
+
+void TextWriter::writeRow(const double* values, size_t n, const std::string& separator)
+{
+    if (threads == 1 || n < parallelThreshold)
+    {
+        const size_t valueSize = maxDoubleSize + separator.size();
+        for (size_t i = 0; i < n; i++)
+        {
+            if (buffer.size() - used < valueSize)
+            {
+                emit(buffer.data(), used);
+                used = 0;
+            }
+            char *p = formatDouble(buffer.data() + used, buffer.data() + buffer.size(), values[i], precision);
+            std::memcpy(p, separator.data(), separator.size());
+            used = p + separator.size() - buffer.data();
+        }
+        return;
+    }
+
+    chunks.resize(threads);
+    pool->parallelFor(threads, [&](size_t first, size_t last)
+    {
+        for (size_t t = first; t < last; t++)
+        {
+            chunks[t].clear();
+            const size_t begin = t * n / threads;
+            const size_t end = (t + 1) * n / threads;
+            format(values + begin, end - begin, separator, chunks[t]);
+        }
+    });
+    for (size_t t = 0; t < threads; t++)
+    {
+        if (buffer.size() - used < chunks[t].size())
+        {
+            emit(buffer.data(), used);
+            used = 0;
+        }
+        if (chunks[t].size() > buffer.size())
+        {
+            emit(chunks[t].data(), chunks[t].size());
+        }
+        else
+        {
+            std::memcpy(buffer.data() + used, chunks[t].data(), chunks[t].size());
+            used += chunks[t].size();
+        }
+    }
+}
+
+void TextWriter::flush()
+{
+    emit(buffer.data(), used);
+    used = 0;
+    out.flush();
+}
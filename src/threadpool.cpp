@@ -0,0 +1,146 @@
+/**
+ * @file threadpool.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link threadpool.h}.
+ * @version 0.1
+ * @date 2023-01-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/threadpool.h"
+
+#include <algorithm>
+
+/**
+ * @brief Pool and index of the worker running on the current thread, if any.
+ *
+ */
+thread_local const ThreadPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t threads) : pending(0), queued(0), next(0), stop(false)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t w = 0; w < threads; w++)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t w = 0; w < threads; w++)
+    {
+        workers.emplace_back(&ThreadPool::run, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return pending == 0; });
+        stop = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    const size_t worker = currentPool == this ? currentWorker : next++ % queues.size();
+    // Counted first, so that the task cannot be done before being counted.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        queues[worker]->tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return pending == 0; });
+    if (error)
+    {
+        std::exception_ptr thrown = std::move(error);
+        error = nullptr;
+        std::rethrow_exception(thrown);
+    }
+}
+
+bool ThreadPool::take(size_t worker, std::function<void()>& task)
+{
+    {
+        Queue &own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        Queue &victim = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t worker)
+{
+    currentPool = this;
+    currentWorker = worker;
+    std::function<void()> task;
+    while (true)
+    {
+        if (take(worker, task))
+        {
+            std::exception_ptr thrown;
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                thrown = std::current_exception();
+            }
+            task = nullptr;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (thrown && !error)
+            {
+                error = std::move(thrown);
+            }
+            if (--pending == 0)
+            {
+                idle.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeUp.wait(lock, [this]() { return stop || queued > 0; });
+        if (stop && queued == 0)
+        {
+            return;
+        }
+    }
+}
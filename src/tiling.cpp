@@ -0,0 +1,162 @@
+/**
+ * @file tiling.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link tiling.h}.
+ * @version 0.1
+ * @date 2023-01-14
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/tiling.h"
+#include "../header/parallel.h"
+#include "../header/stencil.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+size_t tileDepth(size_t ny, size_t steps)
+{
+    // A wave of depth d touches about d + 3 rows of each buffer, which should fit in 1 MB (L2 or a slice of L3).
+    const size_t cacheBytes = size_t(1) << 20;
+    const size_t rows = cacheBytes / (2 * sizeof(double) * std::max<size_t>(ny, 1));
+    const size_t depth = rows > 3 ? rows - 3 : 1;
+    return std::max<size_t>(1, std::min<size_t>({depth, steps, 32}));
+}
+
+/**
+ * @brief Advance batch steps by one skewed wavefront (see {@link tiledStencil5}): step t reads
+ * buffers[(first + t - 1) % 2] and writes buffers[(first + t) % 2].
+ *
+ * @param buffers Both buffers of nx * ny values.
+ * @param first Parity of the buffer holding the values.
+ * @param nx Number of points along x.
+ * @param ny Number of points along y.
+ * @param a Coefficient of the center.
+ * @param bx Coefficient of the neighbours along x.
+ * @param by Coefficient of the neighbours along y.
+ * @param ghost Value outside of the grid.
+ * @param source Source added at each step, or nullptr.
+ * @param sourceScale Coefficient of the source.
+ * @param batch Number of steps.
+ */
+void wavefront(double* const buffers[2], size_t first, size_t nx, size_t ny, double a, double bx, double by, double ghost, const double* source, double sourceScale, size_t batch)
+{
+    // Row r of step t overwrites step t - 2, which is last read by row r + 1 of step t - 1, earlier in the same wave.
+    for (size_t j = 0; j < nx + batch - 1; j++)
+    {
+        for (size_t t = 1; t <= batch; t++)
+        {
+            if (j < t - 1 || j - (t - 1) >= nx)
+            {
+                continue;
+            }
+            const size_t r = j - (t - 1);
+            const double *in = buffers[(first + t - 1) % 2];
+            double *out = buffers[(first + t) % 2];
+            stencil5(in, out, nx, ny, a, bx, by, ghost, r, r + 1);
+            if (source)
+            {
+                double *row = out + r * ny;
+                const double *s = source + r * ny;
+                for (size_t k = 0; k < ny; k++)
+                {
+                    row[k] += sourceScale * s[k];
+                }
+            }
+        }
+    }
+}
+
+void tiledStencil5(double* u, double* work, size_t nx, size_t ny, double a, double bx, double by, double ghost, const double* source, double sourceScale, size_t steps, Workspace& workspace, size_t depth)
+{
+    if (depth == 0)
+    {
+        depth = tileDepth(ny, steps);
+    }
+    double *const buffers[2] = {u, work};
+    const size_t slabs = std::min(ParallelPool::global().size(), nx);
+    if (slabs > 1)
+    {
+        // Each slab recomputes depth rows on both of its sides, which should stay small next to its own rows.
+        depth = std::max<size_t>(1, std::min(depth, nx / slabs / 4));
+    }
+
+    // One window per slab: its rows and depth rows on both sides, for both buffers.
+    Workspace::Frame frame(workspace);
+    const size_t windowSize = slabs > 1 && depth > 1 ? 2 * ((nx + slabs - 1) / slabs + 2 * depth) * ny : 0;
+    double *windows = windowSize > 0 ? frame.take(slabs * windowSize) : nullptr;
+    size_t done = 0;
+    while (done < steps)
+    {
+        const size_t batch = std::min(depth, steps - done);
+        if (slabs <= 1)
+        {
+            wavefront(buffers, done, nx, ny, a, bx, by, ghost, source, sourceScale, batch);
+        }
+        else if (batch == 1)
+        {
+            const double *in = buffers[done % 2];
+            double *out = buffers[(done + 1) % 2];
+            parallelFor(nx, [&](size_t jBegin, size_t jEnd)
+            {
+                stencil5(in, out, nx, ny, a, bx, by, ghost, jBegin, jEnd);
+                if (source)
+                {
+                    for (size_t i = jBegin * ny; i < jEnd * ny; i++)
+                    {
+                        out[i] += sourceScale * source[i];
+                    }
+                }
+            });
+        }
+        else
+        {
+            // Each slab copies its rows and batch rows on both sides, and advances the wave on its copy. The rows
+            // next to a cut are wrong after the first step, but the error moves by one row per step, so it does
+            // not reach the own rows of the slab. They are written back once every slab has read its rows.
+            const double *in = buffers[done % 2];
+            double *out = buffers[(done + batch) % 2];
+            parallelFor(slabs, [&](size_t sBegin, size_t sEnd)
+            {
+                for (size_t s = sBegin; s < sEnd; s++)
+                {
+                    const size_t r0 = s * nx / slabs;
+                    const size_t r1 = (s + 1) * nx / slabs;
+                    const size_t lo = r0 > batch ? r0 - batch : 0;
+                    const size_t hi = std::min(nx, r1 + batch);
+                    const size_t rows = hi - lo;
+                    double *window = windows + s * windowSize;
+                    std::memcpy(window, in + lo * ny, rows * ny * sizeof(double));
+                    double *const local[2] = {window, window + rows * ny};
+                    wavefront(local, 0, rows, ny, a, bx, by, ghost, source ? source + lo * ny : nullptr, sourceScale, batch);
+                }
+            });
+            parallelFor(slabs, [&](size_t sBegin, size_t sEnd)
+            {
+                for (size_t s = sBegin; s < sEnd; s++)
+                {
+                    const size_t r0 = s * nx / slabs;
+                    const size_t r1 = (s + 1) * nx / slabs;
+                    const size_t lo = r0 > batch ? r0 - batch : 0;
+                    const size_t rows = std::min(nx, r1 + batch) - lo;
+                    const double *result = windows + s * windowSize + (batch % 2) * rows * ny;
+                    std::memcpy(out + r0 * ny, result + (r0 - lo) * ny, (r1 - r0) * ny * sizeof(double));
+                }
+            });
+        }
+        done += batch;
+    }
+    if (steps % 2 == 1)
+    {
+        std::memcpy(u, work, nx * ny * sizeof(double));
+    }
+}
+
+void jacobiSweeps(double* x, const double* b, double* work, size_t nx, size_t ny, double shift, double bx, double by, double omega, size_t sweeps, Workspace& workspace)
+{
+    const double scale = omega / (shift + 2 * bx + 2 * by);
+    tiledStencil5(x, work, nx, ny, 1 - omega, scale * bx, scale * by, 0, b, scale, sweeps, workspace);
+}
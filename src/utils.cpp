@@ -11,6 +11,7 @@
 
 #include "../header/utils.h"
 #include "../header/exn.h"
+#include "../header/profile.h"
 
 void addVector(std::vector<double>& v1, const std::vector<double>& v2)
 {
@@ -24,75 +25,175 @@ void addVector(std::vector<double>& v1, const std::vector<double>& v2)
     }
 }
 
-void luDecomp(const std::vector<std::vector<double>>& A, std::vector<std::vector<double>>& L, std::vector<std::vector<double>>& U)
+void luDecomp(const DenseMatrix& A, DenseMatrix& L, DenseMatrix& U)
 {
-    size_t n = A.size();
+    ScopedPhase phase("factorize");
+    size_t n = A.rows();
+    if (A.cols() != n)
+    {
+        throw Exn("Matrix is not square.");
+    }
+    L = DenseMatrix(n, n);
+    U = DenseMatrix(n, n);
     for (size_t i = 0; i < n; i++)
     {
-        L[i][i] = 1.0;
+        L.at(i, i) = 1.0;
     }
-    for (size_t i = 0; i < n - 1; i++)
+    for (size_t i = 0; i < n; i++)
     {
         for (size_t j = i; j < n; j++)
         {
             double tmp = 0.0;
-
-            if (i != 0)
+            for (size_t k = 0; k < i; k++)
             {
-                for (size_t k = 0; k < i - 1; k++)
-                {
-                    tmp += L[i][k] * U[k][j];
-                }
+                tmp += L(i, k) * U(k, j);
             }
-            
-            U[i][j] = (A[i][j]) - tmp;
+            U.at(i, j) = A(i, j) - tmp;
+        }
+        if (U(i, i) == 0.0)
+        {
+            throw Exn("Zero pivot in LU decomposition.");
         }
         for (size_t j = i + 1; j < n; j++)
         {
             double tmp = 0.0;
-            if (i != 0)
+            for (size_t k = 0; k < i; k++)
             {
-                for (size_t k = 0; k < i - 1; k++)
-                {
-                    tmp += L[j][k] * U[k][i];
-                }
+                tmp += L(j, k) * U(k, i);
             }
-            L[j][i] = (A[j][i] - tmp) / U[i][i];
+            L.at(j, i) = (A(j, i) - tmp) / U(i, i);
         }
     }
-    U[n - 1][n - 1] = A[n - 1][n - 1];
-    for (size_t k = 0; k < n - 1; k++)
-    {
-        U[n - 1][n - 1] -= L[n - 1][k] * U[k][n - 1];
-    }
 }
 
-void luSolve(const std::vector<std::vector<double>>& L, const std::vector<std::vector<double>>& U, const std::vector<double>& b, std::vector<double>& x)
+void luSolve(const DenseMatrix& L, const DenseMatrix& U, const std::vector<double>& b, std::vector<double>& x)
 {
-    if (U.size() != b.size())
+    Profiler::count(Counter::Solves);
+    if (U.rows() != b.size())
     {
         throw Exn("Matrix and vector sizes do not match.");
     }
 
-    std::vector<double> y(b.size(), 0);
+    const size_t n = U.rows();
+    x.resize(n);
 
-    for (size_t i = 0; i < U.size(); i++)
+    // L y = b is solved in x, and then U x = y in place: x[i - 1] only reads y[i - 1] and the x[j] already solved.
+    for (size_t i = 0; i < n; i++)
     {
         double tmp = 0.0;
         for (size_t j = 0; j < i; j++)
         {
-            tmp += L[i][j] * y[j];
+            tmp += L(i, j) * x[j];
         }
-        y[i] = b[i] - tmp;
+        x[i] = b[i] - tmp;
     }
 
-    for (size_t i = U.size(); i >= 1; i--)
+    for (size_t i = n; i >= 1; i--)
     {
         double tmp = 0.0;
-        for (size_t j = i; j < U.size() - 1; j++)
+        for (size_t j = i; j < n; j++)
         {
-            tmp += U[i - 1][j] * x[j];
+            tmp += U(i - 1, j) * x[j];
         }
-        x[i - 1] = (y[i - 1] - tmp) / U[i - 1][i - 1];
+        x[i - 1] = (x[i - 1] - tmp) / U(i - 1, i - 1);
+    }
+}
+
+void triDecomp(const std::vector<double>& lower, const std::vector<double>& diag, const std::vector<double>& upper, std::vector<double>& l, std::vector<double>& u)
+{
+    size_t n = diag.size();
+    if (lower.size() != n || upper.size() != n)
+    {
+        throw Exn("Diagonals have different sizes.");
+    }
+    l.assign(n, 0.0);
+    u.assign(n, 0.0);
+    if (n == 0)
+    {
+        return;
+    }
+    u[0] = diag[0];
+    for (size_t i = 1; i < n; i++)
+    {
+        if (u[i - 1] == 0.0)
+        {
+            throw Exn("Zero pivot in tridiagonal decomposition.");
+        }
+        l[i] = lower[i] / u[i - 1];
+        u[i] = diag[i] - l[i] * upper[i - 1];
+    }
+    if (u[n - 1] == 0.0)
+    {
+        throw Exn("Zero pivot in tridiagonal decomposition.");
+    }
+}
+
+void triSolve(const std::vector<double>& l, const std::vector<double>& u, const std::vector<double>& upper, const std::vector<double>& b, std::vector<double>& x)
+{
+    Profiler::count(Counter::Solves);
+    size_t n = u.size();
+    if (l.size() != n || upper.size() != n || b.size() != n)
+    {
+        throw Exn("Matrix and vector sizes do not match.");
     }
-}
\ No newline at end of file
+    x.resize(n);
+    if (n == 0)
+    {
+        return;
+    }
+
+    x[0] = b[0];
+    for (size_t i = 1; i < n; i++)
+    {
+        x[i] = b[i] - l[i] * x[i - 1];
+    }
+
+    x[n - 1] /= u[n - 1];
+    for (size_t i = n - 1; i >= 1; i--)
+    {
+        x[i - 1] = (x[i - 1] - upper[i - 1] * x[i]) / u[i - 1];
+    }
+}
+
+void triSolve(const std::vector<double>& l, const std::vector<double>& u, const std::vector<double>& upper, const double* b, double* x, size_t count, size_t stride)
+{
+    Profiler::count(Counter::Solves);
+    size_t n = u.size();
+    if (n == 0)
+    {
+        return;
+    }
+
+    for (size_t c = 0; c < count; c++)
+    {
+        x[c] = b[c];
+    }
+    for (size_t i = 1; i < n; i++)
+    {
+        const double li = l[i];
+        const double *bi = b + i * stride;
+        double *xi = x + i * stride;
+        const double *xPrev = xi - stride;
+        for (size_t c = 0; c < count; c++)
+        {
+            xi[c] = bi[c] - li * xPrev[c];
+        }
+    }
+
+    double *xLast = x + (n - 1) * stride;
+    for (size_t c = 0; c < count; c++)
+    {
+        xLast[c] /= u[n - 1];
+    }
+    for (size_t i = n - 1; i >= 1; i--)
+    {
+        const double ci = upper[i - 1];
+        const double ui = u[i - 1];
+        double *xi = x + (i - 1) * stride;
+        const double *xNext = xi + stride;
+        for (size_t c = 0; c < count; c++)
+        {
+            xi[c] = (xi[c] - ci * xNext[c]) / ui;
+        }
+    }
+}
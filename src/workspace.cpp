@@ -0,0 +1,77 @@
+/**
+ * @file workspace.cpp
+ * @author Thomas Roiseux
+ * @brief Implements {@link workspace.h}.
+ * @version 0.1
+ * @date 2023-01-18
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "../header/workspace.h"
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief Number of values of a cache line: buffers start on a line, so that two buffers never share one.
+ *
+ */
+constexpr size_t lineValues = 64 / sizeof(double);
+
+Workspace::Workspace() : current(0), used(0), taken(0), peak(0), frames(0)
+{
+}
+
+double* Workspace::take(size_t n)
+{
+    n = (n + lineValues - 1) / lineValues * lineValues;
+    while (current < blocks.size() && blocks[current].size - used < n)
+    {
+        current++;
+        used = 0;
+    }
+    if (current == blocks.size())
+    {
+        // Doubling the blocks bounds the number of allocations of the first steps.
+        const size_t size = std::max(n, blocks.empty() ? 0 : 2 * blocks.back().size);
+        blocks.push_back({std::unique_ptr<double[]>(new double[size + lineValues - 1]), size});
+        used = 0;
+    }
+    double *base = blocks[current].data.get();
+    base += (lineValues - reinterpret_cast<uintptr_t>(base) / sizeof(double) % lineValues) % lineValues;
+    double *buffer = base + used;
+    used += n;
+    taken += n;
+    peak = std::max(peak, taken);
+    return buffer;
+}
+
+void Workspace::merge()
+{
+    if (blocks.size() <= 1)
+    {
+        return;
+    }
+    blocks.clear();
+    blocks.push_back({std::unique_ptr<double[]>(new double[peak + lineValues - 1]), peak});
+    current = 0;
+    used = 0;
+}
+
+Workspace::Frame::Frame(Workspace& workspace) : workspace(workspace), current(workspace.current), used(workspace.used), taken(workspace.taken)
+{
+    workspace.frames++;
+}
+
+Workspace::Frame::~Frame()
+{
+    workspace.current = current;
+    workspace.used = used;
+    workspace.taken = taken;
+    if (--workspace.frames == 0)
+    {
+        workspace.merge();
+    }
+}